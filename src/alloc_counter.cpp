@@ -0,0 +1,46 @@
+//
+//  alloc_counter.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.hpp"
+
+#ifdef POKER_COUNT_ALLOCATIONS
+
+static thread_local long long thread_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++thread_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+bool AllocationCounter::enabled() {
+    return true;
+}
+
+long long AllocationCounter::count() {
+    return thread_allocations;
+}
+
+#else
+
+bool AllocationCounter::enabled() {
+    return false;
+}
+
+long long AllocationCounter::count() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,21 @@
+//
+//  alloc_counter.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef alloc_counter_hpp
+#define alloc_counter_hpp
+
+/* counts calls to the global operator new made by the calling thread.  the
+   counting operator new is only compiled in with -DPOKER_COUNT_ALLOCATIONS,
+   otherwise count() is always 0 and enabled() is false. */
+class AllocationCounter
+{
+public:
+    static bool enabled();
+    static long long count();
+};
+
+#endif /* alloc_counter_hpp */
@@ -0,0 +1,541 @@
+//
+//  batch_evaluator.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <vector>
+#include <chrono>
+
+#include "batch_evaluator.hpp"
+#include "rng.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POKER_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const uint32_t HASH_MULTIPLIER = 2654435761u;
+const int MAX_CARDS = 7;
+
+}
+
+void BatchEvaluator::evaluate(const Card* hands, int ncards, int nhands, int* strengths) {
+    HandEvaluator::State empty = {0, 0, 0};
+    evaluate(empty, hands, ncards, nhands, strengths);
+}
+
+void BatchEvaluator::evaluate(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                              int* strengths) {
+    run(selected(CARDS).load(), base, hands, ncards, nhands, strengths);
+}
+
+/* finished states, e.g. from HandEvaluator::state(), given as their keys and
+   masks in two arrays; all of them must have ncards cards, 5 to 7 */
+void BatchEvaluator::evaluate_states(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                     int* strengths) {
+    run_states(selected(STATES).load(), keys, masks, ncards, nstates, strengths);
+}
+
+/* the kernel evaluate() runs */
+BatchEvaluator::Kernel BatchEvaluator::kernel() {
+    return selected(CARDS).load();
+}
+
+/* the kernel evaluate_states() runs */
+BatchEvaluator::Kernel BatchEvaluator::states_kernel() {
+    return selected(STATES).load();
+}
+
+/* kernel must be supported */
+void BatchEvaluator::set_kernel(Kernel kernel) {
+    set_kernel(kernel, kernel);
+}
+
+void BatchEvaluator::set_kernel(Kernel kernel, Kernel states_kernel) {
+    selected(CARDS).store(kernel);
+    selected(STATES).store(states_kernel);
+}
+
+bool BatchEvaluator::supported(Kernel kernel) {
+#ifdef POKER_X86_KERNELS
+    if(kernel == AVX2) return __builtin_cpu_supports("avx2");
+    if(kernel == AVX512) return __builtin_cpu_supports("avx512f");
+#endif
+    return kernel == SCALAR;
+}
+
+/* scores nhands random hands of 5, 6 and 7 cards (on random bases of 0 to 5
+   cards) with kernel and with the scalar evaluator, both as cards on a base
+   and as finished states, true if all agree */
+bool BatchEvaluator::check(Kernel kernel, int nhands, uint64_t seed) {
+    if(!supported(kernel)) return false;
+    Xoshiro256 rng(seed);
+    std::vector<Card> cards;
+    std::vector<int> expected(nhands), got(nhands);
+    std::vector<uint64_t> keys, masks;
+    for(int total = 5; total <= 7; ++total) {
+        for(int nbase = 0; nbase <= total - 2 && nbase <= 5; ++nbase) {
+            int ncards = total - nbase;
+            // the base is dealt once, the hands from what is left of the deck
+            uint64_t used = 0;
+            Card base_cards[5];
+            for(int i = 0; i < nbase; ) {
+                int c = static_cast<int>(rng.bounded(Card::NUM_CARDS));
+                if(used & (uint64_t(1) << c)) continue;
+                used |= uint64_t(1) << c;
+                base_cards[i++] = Card::from_index(c);
+            }
+            HandEvaluator::State base = HandEvaluator::state(base_cards, nbase);
+            cards.clear();
+            for(int h = 0; h < nhands; ++h) {
+                uint64_t hand_used = used;
+                for(int i = 0; i < ncards; ) {
+                    int c = static_cast<int>(rng.bounded(Card::NUM_CARDS));
+                    if(hand_used & (uint64_t(1) << c)) continue;
+                    hand_used |= uint64_t(1) << c;
+                    cards.push_back(Card::from_index(c));
+                    ++i;
+                }
+            }
+            evaluate_scalar(base, cards.data(), ncards, nhands, expected.data());
+            run(kernel, base, cards.data(), ncards, nhands, got.data());
+            if(expected != got) return false;
+            // the same hands again as finished states
+            keys.resize(nhands);
+            masks.resize(nhands);
+            for(int h = 0; h < nhands; ++h) {
+                HandEvaluator::State state = base;
+                for(int i = 0; i < ncards; ++i) state = HandEvaluator::add(state, cards[h * ncards + i]);
+                keys[h] = state.key;
+                masks[h] = state.mask;
+            }
+            run_states(kernel, keys.data(), masks.data(), total, nhands, got.data());
+            if(expected != got) return false;
+        }
+    }
+    return true;
+}
+
+const char* BatchEvaluator::name(Kernel kernel) {
+    if(kernel == AVX2) return "avx2";
+    if(kernel == AVX512) return "avx512";
+    return "scalar";
+}
+
+/* atomic because set_kernel() may be called while pool workers evaluate */
+std::atomic<BatchEvaluator::Kernel>& BatchEvaluator::selected(Entry entry) {
+    static std::atomic<Kernel> cards_kernel(pick_kernel(CARDS));
+    static std::atomic<Kernel> states_kernel(pick_kernel(STATES));
+    return entry == STATES ? states_kernel : cards_kernel;
+}
+
+/* a SIMD kernel has to beat the best so far by a tenth, so timing noise
+   doesn't pick one that is only as fast */
+BatchEvaluator::Kernel BatchEvaluator::pick_kernel(Entry entry) {
+    Kernel best = SCALAR;
+    double best_time = time_kernel(SCALAR, entry);
+    for(Kernel kernel: {AVX2, AVX512}) {
+        if(!supported(kernel) || !check(kernel, 1000, 2016)) continue;
+        double t = time_kernel(kernel, entry);
+        if(t < 0.9e0 * best_time) {
+            best = kernel;
+            best_time = t;
+        }
+    }
+    return best;
+}
+
+/* the fastest of TIMING_ROUNDS_ runs over TIMING_HANDS_ hands: for
+   evaluate() the pairs of cards left around a board, the way enumeration
+   scores them, and for evaluate_states() random 7 card states, the way
+   trials do */
+double BatchEvaluator::time_kernel(Kernel kernel, Entry entry) {
+    Xoshiro256 rng(2016);
+    uint64_t used = 0;
+    Card board[5];
+    for(int i = 0; i < 5; ) {
+        int c = static_cast<int>(rng.bounded(Card::NUM_CARDS));
+        if(used & (uint64_t(1) << c)) continue;
+        used |= uint64_t(1) << c;
+        board[i++] = Card::from_index(c);
+    }
+    HandEvaluator::State base = HandEvaluator::state(board, 5);
+    std::vector<Card> cards;
+    for(int i = 0; i < Card::NUM_CARDS && int(cards.size()) < 2 * TIMING_HANDS_; ++i) {
+        for(int j = i + 1; j < Card::NUM_CARDS && int(cards.size()) < 2 * TIMING_HANDS_; ++j) {
+            if(used & ((uint64_t(1) << i) | (uint64_t(1) << j))) continue;
+            cards.push_back(Card::from_index(i));
+            cards.push_back(Card::from_index(j));
+        }
+    }
+    int nhands = static_cast<int>(cards.size()) / 2;
+    std::vector<uint64_t> keys, masks;
+    for(int h = 0; h < TIMING_HANDS_; ++h) {
+        uint64_t hand_used = 0;
+        HandEvaluator::State state = {0, 0, 0};
+        for(int i = 0; i < 7; ) {
+            int c = static_cast<int>(rng.bounded(Card::NUM_CARDS));
+            if(hand_used & (uint64_t(1) << c)) continue;
+            hand_used |= uint64_t(1) << c;
+            state = HandEvaluator::add(state, Card::from_index(c));
+            ++i;
+        }
+        keys.push_back(state.key);
+        masks.push_back(state.mask);
+    }
+    std::vector<int> strengths(TIMING_HANDS_);
+    double fastest = 1.0e30;
+    // round 0 only warms the caches up
+    for(int round = 0; round <= TIMING_ROUNDS_; ++round) {
+        auto t0 = std::chrono::steady_clock::now();
+        if(entry == STATES) run_states(kernel, keys.data(), masks.data(), 7, TIMING_HANDS_, strengths.data());
+        else run(kernel, base, cards.data(), 2, nhands, strengths.data());
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if(round > 0 && t < fastest) fastest = t;
+    }
+    return fastest;
+}
+
+void BatchEvaluator::run(Kernel kernel, const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                         int* strengths) {
+    int total = base.ncards + ncards;
+    if(total < 5 || total > 7 || ncards < 1) kernel = SCALAR;
+    if(kernel == AVX512) evaluate_avx512(base, hands, ncards, nhands, strengths);
+    else if(kernel == AVX2) evaluate_avx2(base, hands, ncards, nhands, strengths);
+    else evaluate_scalar(base, hands, ncards, nhands, strengths);
+}
+
+void BatchEvaluator::run_states(Kernel kernel, const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                int* strengths) {
+    if(ncards < 5 || ncards > 7) {
+        for(int h = 0; h < nstates; ++h) strengths[h] = 0;
+        return;
+    }
+    if(kernel == AVX512) evaluate_states_avx512(keys, masks, ncards, nstates, strengths);
+    else if(kernel == AVX2) evaluate_states_avx2(keys, masks, ncards, nstates, strengths);
+    else evaluate_states_scalar(keys, masks, ncards, nstates, strengths);
+}
+
+void BatchEvaluator::evaluate_scalar(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                                     int* strengths) {
+    for(int h = 0; h < nhands; ++h) {
+        HandEvaluator::State state = base;
+        for(int i = 0; i < ncards; ++i) state = HandEvaluator::add(state, hands[h * ncards + i]);
+        strengths[h] = HandEvaluator::evaluate(state);
+    }
+}
+
+void BatchEvaluator::evaluate_states_scalar(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                            int* strengths) {
+    for(int h = 0; h < nstates; ++h) {
+        strengths[h] = HandEvaluator::lookup(keys[h], masks[h], ncards);
+    }
+}
+
+/* the rank and flush tables of one hand size, as the kernels read them */
+struct LookupTables {
+    const int* rank_table;
+    int bits;
+    const int* flush_table;
+    int empty_key;
+};
+
+LookupTables BatchEvaluator::tables(int ncards) {
+    LookupTables tables;
+    tables.rank_table = reinterpret_cast<const int*>(HandEvaluator::tables().rank_tables[ncards - 5]);
+    tables.bits = HandEvaluator::RANK_TABLE_BITS_[ncards - 5];
+    tables.flush_table = reinterpret_cast<const int*>(HandEvaluator::tables().flush);
+    tables.empty_key = static_cast<int>(HandEvaluator::EMPTY_KEY_);
+    return tables;
+}
+
+#ifdef POKER_X86_KERNELS
+
+namespace {
+
+/* strengths of 8 hands from their rank keys, suit counters and the two
+   halves of their rank masks: a flush is a gather from the flush table,
+   anything else a linear probe in which only the lanes still looking move
+   on, with the strengths fetched once every lane has found its slot */
+__attribute__((target("avx2")))
+inline __m256i lookup_avx2(__m256i rank_key, __m256i suits, __m256i mask_low, __m256i mask_high,
+                           const LookupTables& tables) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i rank_bits = _mm256_set1_epi32(0x1fff);
+    const __m256i empty_key = _mm256_set1_epi32(tables.empty_key);
+    // suit counters start at 3 so a count of 5 or more sets the top bit of its nibble
+    __m256i flush = _mm256_and_si256(_mm256_add_epi32(suits, _mm256_set1_epi32(0x3333)), _mm256_set1_epi32(0x8888));
+    __m256i flush_ranks = _mm256_setzero_si256();
+    const int flush_bits[4] = {0x8, 0x80, 0x800, 0x8000};
+    __m256i words[4] = {mask_low, _mm256_srli_epi32(mask_low, 16), mask_high, _mm256_srli_epi32(mask_high, 16)};
+    for(int s = 0; s < Card::NUM_SUITS; ++s) {
+        __m256i bit = _mm256_set1_epi32(flush_bits[s]);
+        __m256i is_suit = _mm256_cmpeq_epi32(_mm256_and_si256(flush, bit), bit);
+        flush_ranks = _mm256_or_si256(flush_ranks, _mm256_and_si256(is_suit, _mm256_and_si256(words[s], rank_bits)));
+    }
+    __m256i is_flush = _mm256_xor_si256(_mm256_cmpeq_epi32(flush, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+    // the flush table has a spare entry, so reading 4 bytes at the last one stays inside
+    __m256i strength = _mm256_setzero_si256();
+    if(_mm256_movemask_ps(_mm256_castsi256_ps(is_flush))) {
+        strength = _mm256_and_si256(_mm256_mask_i32gather_epi32(strength, tables.flush_table, flush_ranks, is_flush, 2),
+                                    _mm256_set1_epi32(0xffff));
+    }
+    __m256i active = _mm256_xor_si256(is_flush, _mm256_set1_epi32(-1));
+    __m256i found = _mm256_setzero_si256();
+    __m256i slot_mask = _mm256_set1_epi32((1 << tables.bits) - 1);
+    __m256i slot = _mm256_srli_epi32(_mm256_mullo_epi32(rank_key, _mm256_set1_epi32(static_cast<int>(HASH_MULTIPLIER))),
+                                     32 - tables.bits);
+    while(_mm256_movemask_ps(_mm256_castsi256_ps(active))) {
+        __m256i key = _mm256_mask_i32gather_epi32(empty_key, tables.rank_table, _mm256_add_epi32(slot, slot), active, 4);
+        __m256i hit = _mm256_and_si256(active, _mm256_cmpeq_epi32(key, rank_key));
+        __m256i miss = _mm256_and_si256(active, _mm256_cmpeq_epi32(key, empty_key));
+        found = _mm256_or_si256(found, hit);
+        active = _mm256_andnot_si256(_mm256_or_si256(hit, miss), active);
+        slot = _mm256_and_si256(_mm256_add_epi32(slot, _mm256_and_si256(active, one)), slot_mask);
+    }
+    if(_mm256_movemask_ps(_mm256_castsi256_ps(found))) {
+        strength = _mm256_mask_i32gather_epi32(strength, tables.rank_table,
+                                               _mm256_add_epi32(_mm256_add_epi32(slot, slot), one), found, 4);
+    }
+    return strength;
+}
+
+/* the same for 16 hands, with mask registers */
+__attribute__((target("avx512f")))
+inline __m512i lookup_avx512(__m512i rank_key, __m512i suits, __m512i mask_low, __m512i mask_high,
+                             const LookupTables& tables) {
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i rank_bits = _mm512_set1_epi32(0x1fff);
+    const __m512i empty_key = _mm512_set1_epi32(tables.empty_key);
+    __m512i flush = _mm512_and_si512(_mm512_add_epi32(suits, _mm512_set1_epi32(0x3333)), _mm512_set1_epi32(0x8888));
+    __m512i flush_ranks = _mm512_setzero_si512();
+    const int flush_bits[4] = {0x8, 0x80, 0x800, 0x8000};
+    __m512i words[4] = {mask_low, _mm512_srli_epi32(mask_low, 16), mask_high, _mm512_srli_epi32(mask_high, 16)};
+    for(int s = 0; s < Card::NUM_SUITS; ++s) {
+        __mmask16 is_suit = _mm512_test_epi32_mask(flush, _mm512_set1_epi32(flush_bits[s]));
+        flush_ranks = _mm512_mask_or_epi32(flush_ranks, is_suit, flush_ranks, _mm512_and_si512(words[s], rank_bits));
+    }
+    __mmask16 is_flush = _mm512_test_epi32_mask(flush, flush);
+    __m512i strength = _mm512_setzero_si512();
+    if(is_flush) {
+        strength = _mm512_and_si512(_mm512_mask_i32gather_epi32(strength, is_flush, flush_ranks, tables.flush_table, 2),
+                                    _mm512_set1_epi32(0xffff));
+    }
+    __mmask16 active = static_cast<__mmask16>(~is_flush);
+    __mmask16 found = 0;
+    __m512i slot_mask = _mm512_set1_epi32((1 << tables.bits) - 1);
+    __m512i slot = _mm512_srli_epi32(_mm512_mullo_epi32(rank_key, _mm512_set1_epi32(static_cast<int>(HASH_MULTIPLIER))),
+                                     32 - tables.bits);
+    while(active) {
+        __m512i key = _mm512_mask_i32gather_epi32(empty_key, active, _mm512_add_epi32(slot, slot), tables.rank_table, 4);
+        __mmask16 hit = _mm512_mask_cmpeq_epi32_mask(active, key, rank_key);
+        __mmask16 miss = _mm512_mask_cmpeq_epi32_mask(active, key, empty_key);
+        found = static_cast<__mmask16>(found | hit);
+        active = static_cast<__mmask16>(active & ~(hit | miss));
+        slot = _mm512_and_si512(_mm512_mask_add_epi32(slot, active, slot, one), slot_mask);
+    }
+    if(found) {
+        strength = _mm512_mask_i32gather_epi32(strength, found, _mm512_add_epi32(_mm512_add_epi32(slot, slot), one),
+                                               tables.rank_table, 4);
+    }
+    return strength;
+}
+
+}
+
+/* 8 hands per step.  the cards are transposed into one row of 8 bytes per
+   card position first, so each position loads as one vector of indices.
+   a short last step repeats the first hand in its spare lanes. */
+__attribute__((target("avx2")))
+void BatchEvaluator::evaluate_avx2(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                                   int* strengths) {
+    const int LANES = 8;
+    LookupTables lookup = tables(base.ncards + ncards);
+    const int* card_keys = reinterpret_cast<const int*>(HandEvaluator::tables().card_keys);
+    const __m256i one = _mm256_set1_epi32(1);
+    alignas(32) uint8_t rows[MAX_CARDS][LANES];
+    alignas(32) int out[LANES];
+    for(int first = 0; first < nhands; first += LANES) {
+        int n = nhands - first < LANES ? nhands - first : LANES;
+        // two card hands (hole cards on a board) load straight from the input, one 16 bit pair per lane
+        bool pairs = ncards == 2 && n == LANES;
+        __m256i pair_cards = _mm256_setzero_si256();
+        if(pairs) {
+            pair_cards = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hands + first * 2)));
+        } else {
+            for(int h = 0; h < LANES; ++h) {
+                const Card* hand = hands + (first + (h < n ? h : 0)) * ncards;
+                for(int i = 0; i < ncards; ++i) rows[i][h] = static_cast<uint8_t>(hand[i].get_index());
+            }
+        }
+        __m256i rank_key = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.key)));
+        __m256i suits = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.key >> 32)));
+        __m256i mask_low = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.mask)));
+        __m256i mask_high = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.mask >> 32)));
+        for(int i = 0; i < ncards; ++i) {
+            __m256i c = pairs ? _mm256_and_si256(_mm256_srli_epi32(pair_cards, 8 * i), _mm256_set1_epi32(0xff))
+                              : _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[i])));
+            __m256i rank = _mm256_srli_epi32(c, 2);
+            __m256i suit = _mm256_and_si256(c, _mm256_set1_epi32(3));
+            // the low 32 bits of the card's key are its rank key
+            rank_key = _mm256_add_epi32(rank_key, _mm256_i32gather_epi32(card_keys, _mm256_add_epi32(c, c), 4));
+            suits = _mm256_add_epi32(suits, _mm256_sllv_epi32(one, _mm256_slli_epi32(suit, 2)));
+            // bit 16 * suit + rank, split over two words; shifts of 32 or more give 0
+            __m256i shift = _mm256_add_epi32(rank, _mm256_slli_epi32(suit, 4));
+            mask_low = _mm256_or_si256(mask_low, _mm256_sllv_epi32(one, shift));
+            mask_high = _mm256_or_si256(mask_high, _mm256_sllv_epi32(one, _mm256_sub_epi32(shift, _mm256_set1_epi32(32))));
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out), lookup_avx2(rank_key, suits, mask_low, mask_high, lookup));
+        for(int h = 0; h < n; ++h) strengths[first + h] = out[h];
+    }
+}
+
+/* the same with 16 lanes */
+__attribute__((target("avx512f")))
+void BatchEvaluator::evaluate_avx512(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                                     int* strengths) {
+    const int LANES = 16;
+    LookupTables lookup = tables(base.ncards + ncards);
+    const int* card_keys = reinterpret_cast<const int*>(HandEvaluator::tables().card_keys);
+    const __m512i one = _mm512_set1_epi32(1);
+    alignas(64) uint8_t rows[MAX_CARDS][LANES];
+    alignas(64) int out[LANES];
+    for(int first = 0; first < nhands; first += LANES) {
+        int n = nhands - first < LANES ? nhands - first : LANES;
+        bool pairs = ncards == 2 && n == LANES;
+        __m512i pair_cards = _mm512_setzero_si512();
+        if(pairs) {
+            pair_cards = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hands + first * 2)));
+        } else {
+            for(int h = 0; h < LANES; ++h) {
+                const Card* hand = hands + (first + (h < n ? h : 0)) * ncards;
+                for(int i = 0; i < ncards; ++i) rows[i][h] = static_cast<uint8_t>(hand[i].get_index());
+            }
+        }
+        __m512i rank_key = _mm512_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.key)));
+        __m512i suits = _mm512_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.key >> 32)));
+        __m512i mask_low = _mm512_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.mask)));
+        __m512i mask_high = _mm512_set1_epi32(static_cast<int>(static_cast<uint32_t>(base.mask >> 32)));
+        for(int i = 0; i < ncards; ++i) {
+            __m512i c = pairs ? _mm512_and_si512(_mm512_srli_epi32(pair_cards, 8 * i), _mm512_set1_epi32(0xff))
+                              : _mm512_cvtepu8_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(rows[i])));
+            __m512i rank = _mm512_srli_epi32(c, 2);
+            __m512i suit = _mm512_and_si512(c, _mm512_set1_epi32(3));
+            rank_key = _mm512_add_epi32(rank_key, _mm512_i32gather_epi32(_mm512_add_epi32(c, c), card_keys, 4));
+            suits = _mm512_add_epi32(suits, _mm512_sllv_epi32(one, _mm512_slli_epi32(suit, 2)));
+            __m512i shift = _mm512_add_epi32(rank, _mm512_slli_epi32(suit, 4));
+            mask_low = _mm512_or_si512(mask_low, _mm512_sllv_epi32(one, shift));
+            mask_high = _mm512_or_si512(mask_high, _mm512_sllv_epi32(one, _mm512_sub_epi32(shift, _mm512_set1_epi32(32))));
+        }
+        _mm512_store_si512(reinterpret_cast<__m512i*>(out), lookup_avx512(rank_key, suits, mask_low, mask_high, lookup));
+        for(int h = 0; h < n; ++h) strengths[first + h] = out[h];
+    }
+}
+
+/* finished states, 8 per step: the low and high words of 8 keys (and masks)
+   are split into two vectors by a permute */
+__attribute__((target("avx2")))
+void BatchEvaluator::evaluate_states_avx2(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                          int* strengths) {
+    const int LANES = 8;
+    LookupTables lookup = tables(ncards);
+    const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    alignas(32) uint64_t tail_keys[LANES];
+    alignas(32) uint64_t tail_masks[LANES];
+    alignas(32) int out[LANES];
+    for(int first = 0; first < nstates; first += LANES) {
+        int n = nstates - first < LANES ? nstates - first : LANES;
+        const uint64_t* k = keys + first;
+        const uint64_t* m = masks + first;
+        if(n < LANES) {
+            for(int h = 0; h < LANES; ++h) {
+                tail_keys[h] = keys[first + (h < n ? h : 0)];
+                tail_masks[h] = masks[first + (h < n ? h : 0)];
+            }
+            k = tail_keys;
+            m = tail_masks;
+        }
+        __m256i k0 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(k)), split);
+        __m256i k1 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(k + 4)), split);
+        __m256i m0 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m)), split);
+        __m256i m1 = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(m + 4)), split);
+        __m256i strength = lookup_avx2(_mm256_permute2x128_si256(k0, k1, 0x20), _mm256_permute2x128_si256(k0, k1, 0x31),
+                                       _mm256_permute2x128_si256(m0, m1, 0x20), _mm256_permute2x128_si256(m0, m1, 0x31),
+                                       lookup);
+        if(n == LANES) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(strengths + first), strength);
+        } else {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(out), strength);
+            for(int h = 0; h < n; ++h) strengths[first + h] = out[h];
+        }
+    }
+}
+
+/* 16 per step, the words split by narrowing conversions */
+__attribute__((target("avx512f")))
+void BatchEvaluator::evaluate_states_avx512(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                            int* strengths) {
+    const int LANES = 16;
+    LookupTables lookup = tables(ncards);
+    alignas(64) uint64_t tail_keys[LANES];
+    alignas(64) uint64_t tail_masks[LANES];
+    alignas(64) int out[LANES];
+    for(int first = 0; first < nstates; first += LANES) {
+        int n = nstates - first < LANES ? nstates - first : LANES;
+        const uint64_t* k = keys + first;
+        const uint64_t* m = masks + first;
+        if(n < LANES) {
+            for(int h = 0; h < LANES; ++h) {
+                tail_keys[h] = keys[first + (h < n ? h : 0)];
+                tail_masks[h] = masks[first + (h < n ? h : 0)];
+            }
+            k = tail_keys;
+            m = tail_masks;
+        }
+        __m512i k0 = _mm512_loadu_si512(k);
+        __m512i k1 = _mm512_loadu_si512(k + 8);
+        __m512i m0 = _mm512_loadu_si512(m);
+        __m512i m1 = _mm512_loadu_si512(m + 8);
+        __m512i rank_key = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(k0)), _mm512_cvtepi64_epi32(k1), 1);
+        __m512i suits = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(_mm512_srli_epi64(k0, 32))),
+                                           _mm512_cvtepi64_epi32(_mm512_srli_epi64(k1, 32)), 1);
+        __m512i mask_low = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(m0)), _mm512_cvtepi64_epi32(m1), 1);
+        __m512i mask_high = _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi64_epi32(_mm512_srli_epi64(m0, 32))),
+                                               _mm512_cvtepi64_epi32(_mm512_srli_epi64(m1, 32)), 1);
+        __m512i strength = lookup_avx512(rank_key, suits, mask_low, mask_high, lookup);
+        if(n == LANES) {
+            _mm512_storeu_si512(strengths + first, strength);
+        } else {
+            _mm512_store_si512(out, strength);
+            for(int h = 0; h < n; ++h) strengths[first + h] = out[h];
+        }
+    }
+}
+
+#else
+
+void BatchEvaluator::evaluate_avx2(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                                   int* strengths) {
+    evaluate_scalar(base, hands, ncards, nhands, strengths);
+}
+
+void BatchEvaluator::evaluate_avx512(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                                     int* strengths) {
+    evaluate_scalar(base, hands, ncards, nhands, strengths);
+}
+
+void BatchEvaluator::evaluate_states_avx2(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                          int* strengths) {
+    evaluate_states_scalar(keys, masks, ncards, nstates, strengths);
+}
+
+void BatchEvaluator::evaluate_states_avx512(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                            int* strengths) {
+    evaluate_states_scalar(keys, masks, ncards, nstates, strengths);
+}
+
+#endif
@@ -0,0 +1,76 @@
+//
+//  batch_evaluator.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef batch_evaluator_hpp
+#define batch_evaluator_hpp
+
+#include <cstdint>
+#include <atomic>
+
+#include "card.hpp"
+#include "hand_evaluator.hpp"
+
+struct LookupTables;
+
+/* HandEvaluator for many hands at once.  the AVX2 kernel scores 8 hands per
+   step and the AVX-512 one 16, one hand per 32 bit lane: the rank keys are
+   gathered, suit counters and rank masks are built with variable shifts and
+   the flush and rank table lookups are gathers too, with the linear probe
+   repeated only for the lanes that haven't found their key.
+
+   evaluate() and evaluate_states() each pick their kernel on first use:
+   of the ones the CPU (by CPUID) supports and that score a sample of hands
+   exactly like the scalar one, whichever is fastest on a short timed
+   batch of their own kind of work.  wider isn't always faster, the
+   gathers can cost more than they save.  set_kernel() overrides both,
+   e.g. to compare them.
+
+   hands are ncards consecutive cards each, added to a base state (e.g. the
+   board) that all of them share; base plus ncards must be 5 to 7 cards.
+   evaluate_states() scores hands already folded into states, kept as
+   separate key and mask arrays so each kernel step loads them whole. */
+class BatchEvaluator
+{
+public:
+    enum Kernel { SCALAR, AVX2, AVX512 };
+    static void evaluate(const Card* hands, int ncards, int nhands, int* strengths);
+    static void evaluate(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands, int* strengths);
+    static void evaluate_states(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates, int* strengths);
+    static Kernel kernel();
+    static Kernel states_kernel();
+    static void set_kernel(Kernel kernel);
+    static void set_kernel(Kernel kernel, Kernel states_kernel);
+    static bool supported(Kernel kernel);
+    static bool check(Kernel kernel, int nhands, uint64_t seed);
+    static const char* name(Kernel kernel);
+private:
+    enum Entry { CARDS, STATES };
+    static const int TIMING_HANDS_ = 1024;
+    static const int TIMING_ROUNDS_ = 16;
+    static std::atomic<Kernel>& selected(Entry entry);
+    static Kernel pick_kernel(Entry entry);
+    static double time_kernel(Kernel kernel, Entry entry);
+    static void run(Kernel kernel, const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                    int* strengths);
+    static void run_states(Kernel kernel, const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                           int* strengths);
+    static LookupTables tables(int ncards);
+    static void evaluate_scalar(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                                int* strengths);
+    static void evaluate_avx2(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                              int* strengths);
+    static void evaluate_avx512(const HandEvaluator::State& base, const Card* hands, int ncards, int nhands,
+                                int* strengths);
+    static void evaluate_states_scalar(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                       int* strengths);
+    static void evaluate_states_avx2(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                     int* strengths);
+    static void evaluate_states_avx512(const uint64_t* keys, const uint64_t* masks, int ncards, int nstates,
+                                       int* strengths);
+};
+
+#endif /* batch_evaluator_hpp */
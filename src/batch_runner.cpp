@@ -0,0 +1,217 @@
+//
+//  batch_runner.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <limits>
+
+#include "batch_runner.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if(begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+std::string csv_field(const std::string& s) {
+    if(s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string quoted = "\"";
+    for(char c: s) {
+        if(c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/* control characters can't appear raw in a JSON string, so they go out as \u00XX */
+std::string json_string(const std::string& s) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string escaped = "\"";
+    for(char c: s) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if(u < 0x20) {
+            escaped += "\\u00";
+            escaped += HEX[u >> 4];
+            escaped += HEX[u & 0xf];
+            continue;
+        }
+        if(c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+}
+
+BatchRunner::BatchRunner(std::istream& in, std::ostream& out, Format format, uint64_t seed)
+    : in_(in), out_(out), format_(format), seed_(seed) { }
+
+/* reads and answers scenarios until the input runs out, returns how many there were */
+long BatchRunner::run() {
+    if(format_ == CSV) out_ << "id,hole,board,players,trials,win,tie,equity,error" << std::endl;
+    EquityEngine engine(ThreadPool::instance());
+    std::vector<Scenario> block;
+    std::string line;
+    long line_number = 0;
+    long nscenarios = 0;
+    while(std::getline(in_, line)) {
+        ++line_number;
+        line = trim(line);
+        if(line.empty() || line[0] == '#') continue;
+        block.push_back(parse(line, line_number));
+        if(block.size() == SCENARIOS_PER_BLOCK_) {
+            run_block(engine, block);
+            nscenarios += block.size();
+            block.clear();
+        }
+    }
+    run_block(engine, block);
+    nscenarios += block.size();
+    return nscenarios;
+}
+
+BatchRunner::Scenario BatchRunner::parse(const std::string& line, long line_number) const {
+    Scenario scenario;
+    scenario.id = std::to_string(line_number);
+    scenario.nplayers = 2;
+    scenario.ntrials = 100000;
+    scenario.seed = scenario_seed(seed_, line_number);
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while(std::getline(ss, field, '|')) fields.push_back(trim(field));
+    if(fields.size() < 2) {
+        scenario.error = "expected hole cards | board";
+        return scenario;
+    }
+    if(!parse_cards(fields[0], scenario.hole_cards) || scenario.hole_cards.size() != 2) {
+        scenario.error = "bad hole cards \"" + fields[0] + "\"";
+        return scenario;
+    }
+    if(fields[1] != "-" && !parse_cards(fields[1], scenario.board)) {
+        scenario.error = "bad board \"" + fields[1] + "\"";
+        return scenario;
+    }
+    for(size_t i = 2; i < fields.size(); ++i) {
+        size_t eq = fields[i].find('=');
+        std::string key = trim(fields[i].substr(0, eq));
+        std::string value = eq == std::string::npos ? "" : trim(fields[i].substr(eq + 1));
+        char* end = nullptr;
+        if(key == "id") {
+            scenario.id = value;
+        } else if(key == "players") {
+            scenario.nplayers = static_cast<int>(std::strtol(value.c_str(), &end, 10));
+            if(value.empty() || *end || scenario.nplayers < 2 || scenario.nplayers > TrialEngine::MAX_PLAYERS)
+                scenario.error = "players must be 2 to 10";
+        } else if(key == "trials") {
+            scenario.ntrials = static_cast<long long>(std::strtod(value.c_str(), &end));
+            if(value.empty() || *end || scenario.ntrials < 1) scenario.error = "bad trials \"" + value + "\"";
+        } else if(key == "seed") {
+            scenario.seed = std::strtoull(value.c_str(), &end, 10);
+            if(value.empty() || *end) scenario.error = "bad seed \"" + value + "\"";
+        } else if(key == "dead") {
+            if(!parse_cards(value, scenario.dead_cards)) scenario.error = "bad dead cards \"" + value + "\"";
+        } else {
+            scenario.error = "unknown field \"" + fields[i] + "\"";
+        }
+        if(!scenario.error.empty()) return scenario;
+    }
+    return scenario;
+}
+
+/* the seed and line number through the splitmix64 finalizer.  seeds that
+   are only a constant apart would give Xoshiro256 overlapping states, so
+   the line number can't just be added */
+uint64_t BatchRunner::scenario_seed(uint64_t seed, long line_number) {
+    uint64_t z = seed + uint64_t(line_number) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/* cards written back to back, e.g. "2c7d9s", spaces allowed */
+bool BatchRunner::parse_cards(const std::string& text, std::vector<Card>& cards) {
+    std::string compact;
+    for(char c: text) {
+        if(c != ' ' && c != '\t') compact += c;
+    }
+    if(compact.size() % 2) return false;
+    for(size_t i = 0; i < compact.size(); i += 2) {
+        Card c;
+        if(!Card::from_str(compact.substr(i, 2), c)) return false;
+        cards.push_back(c);
+    }
+    return true;
+}
+
+/* exactly every scenario's trials, sampled by the engine in one batch, which
+   checks the cards and runs the chunks of all the scenarios on the pool
+   together; then the block is printed in order */
+void BatchRunner::run_block(const EquityEngine& engine, std::vector<Scenario>& block) const {
+    std::vector<EquityQuery> queries;
+    std::vector<Scenario*> asked;
+    for(Scenario& scenario: block) {
+        if(!scenario.error.empty()) continue;
+        EquityQuery query;
+        query.hole_cards = scenario.hole_cards;
+        query.board = scenario.board;
+        query.dead_cards = scenario.dead_cards;
+        query.nplayers = scenario.nplayers;
+        query.seed = scenario.seed;
+        query.max_trials = scenario.ntrials;
+        query.max_seconds = std::numeric_limits<double>::infinity();
+        query.target_half_width = 0.0e0;
+        queries.push_back(query);
+        asked.push_back(&scenario);
+    }
+    std::vector<EquityResult> results = engine.monte_carlo_batch(queries);
+    for(size_t i = 0; i < asked.size(); ++i) {
+        asked[i]->result = results[i];
+        asked[i]->error = results[i].error;
+    }
+    for(const Scenario& scenario: block) print(scenario);
+    out_.flush();
+}
+
+void BatchRunner::print(const Scenario& scenario) const {
+    std::ostringstream line;
+    line << std::setprecision(6) << std::fixed;
+    double win = scenario.result.win;
+    double tie = scenario.result.tie;
+    double equity = scenario.result.equity;
+    if(format_ == CSV) {
+        line << csv_field(scenario.id) << "," << cards_str(scenario.hole_cards) << "," << cards_str(scenario.board) << ",";
+        if(scenario.error.empty()) {
+            line << scenario.nplayers << "," << scenario.ntrials << "," << win << "," << tie << "," << equity << ",";
+        } else {
+            line << ",,,,," << csv_field(scenario.error);
+        }
+    } else {
+        line << "{\"id\":" << json_string(scenario.id);
+        if(scenario.error.empty()) {
+            line << ",\"hole\":" << json_string(cards_str(scenario.hole_cards))
+                 << ",\"board\":" << json_string(cards_str(scenario.board))
+                 << ",\"players\":" << scenario.nplayers << ",\"trials\":" << scenario.ntrials
+                 << ",\"win\":" << win << ",\"tie\":" << tie << ",\"equity\":" << equity;
+        } else {
+            line << ",\"error\":" << json_string(scenario.error);
+        }
+        line << "}";
+    }
+    out_ << line.str() << "\n";
+}
+
+std::string BatchRunner::cards_str(const std::vector<Card>& cards) {
+    std::string s;
+    for(const Card& c: cards) s += c.str();
+    return s;
+}
@@ -0,0 +1,70 @@
+//
+//  batch_runner.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef batch_runner_hpp
+#define batch_runner_hpp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "card.hpp"
+#include "trial_engine.hpp"
+#include "equity_engine.hpp"
+
+/* non-interactive mode: one scenario per line, fields split by '|'
+
+     AhKh | 2c7d9s | players=6 | trials=1e6 | dead=Qs | id=hand42 | seed=7
+
+   the hole cards come first and the board second (empty or "-" preflop),
+   the rest are optional key=value fields.  the id defaults to the line
+   number, players to 2 and trials to 100000.  a scenario without a seed
+   gets the runner's seed mixed with its line number, so no two scenarios
+   of a run share a stream.
+   blank lines and lines starting with '#' are skipped.
+
+   scenarios are read in blocks of SCENARIOS_PER_BLOCK_ and every block is
+   sampled by EquityEngine::monte_carlo_batch, which checks the cards like
+   for any other front end and runs the chunks of all the block's scenarios
+   on the thread pool together, so a file of small scenarios still keeps
+   every core busy.  each scenario's chunks follow its own seed, so the
+   numbers don't depend on the block size or the thread count.  results are
+   printed in input order, one CSV or JSON line per scenario, a block at a
+   time. */
+class BatchRunner
+{
+public:
+    enum Format { CSV, JSON };
+    BatchRunner(std::istream& in, std::ostream& out, Format format, uint64_t seed);
+    long run();
+private:
+    static const size_t SCENARIOS_PER_BLOCK_ = 64;
+    struct Scenario {
+        std::string id;
+        std::vector<Card> hole_cards;
+        std::vector<Card> board;
+        std::vector<Card> dead_cards;
+        int nplayers;
+        long long ntrials;
+        uint64_t seed;
+        std::string error;
+        EquityResult result;
+    };
+    std::istream& in_;
+    std::ostream& out_;
+    Format format_;
+    uint64_t seed_;
+    Scenario parse(const std::string& line, long line_number) const;
+    static bool parse_cards(const std::string& text, std::vector<Card>& cards);
+    static uint64_t scenario_seed(uint64_t seed, long line_number);
+    void run_block(const EquityEngine& engine, std::vector<Scenario>& block) const;
+    void print(const Scenario& scenario) const;
+    static std::string cards_str(const std::vector<Card>& cards);
+};
+
+#endif /* batch_runner_hpp */
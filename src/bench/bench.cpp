@@ -0,0 +1,269 @@
+//
+//  bench.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+#include "card.hpp"
+#include "deck.hpp"
+#include "poker_hand.hpp"
+#include "hand.hpp"
+#include "poker_game.hpp"
+#include "hand_evaluator.hpp"
+#include "batch_evaluator.hpp"
+#include "trial_engine.hpp"
+#include "alloc_counter.hpp"
+#include "misc.hpp"
+#include "card_set.hpp"
+#include "rng.hpp"
+
+/* microbenchmarks of the hot paths.
+
+     bench [results.json] [seconds per benchmark]
+
+   every benchmark repeats its body until it has run for the given time
+   (0.5 s by default) and reports ns per op and hand evaluations per second,
+   plus heap allocations per op when built with -DPOKER_COUNT_ALLOCATIONS.
+   the results file holds one object per benchmark so runs of two builds
+   can be diffed or compared by script. */
+
+namespace {
+
+struct Result {
+    std::string name;
+    long long nops;
+    double ns_per_op;
+    double evals_per_second;
+    double allocations_per_op;
+};
+
+const int NHANDS = 1024;
+volatile long long sink;
+
+/* calls body(i) for i = 0, 1, ... in rounds until min_seconds have passed.
+   every call is one op worth evals_per_op hand evaluations. */
+template <typename F>
+Result measure(const std::string& name, double evals_per_op, double min_seconds, F body) {
+    long long nops = 0;
+    long long checksum = 0;
+    long long round = 64;
+    long long allocations = AllocationCounter::count();
+    auto t0 = std::chrono::high_resolution_clock::now();
+    double elapsed = 0.0e0;
+    while(elapsed < min_seconds) {
+        for(long long i = 0; i < round; ++i) checksum += body(nops + i);
+        nops += round;
+        round *= 2;
+        elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+    }
+    sink = checksum;
+    Result result;
+    result.name = name;
+    result.nops = nops;
+    result.ns_per_op = elapsed * 1.0e9 / nops;
+    result.evals_per_second = evals_per_op * nops / elapsed;
+    result.allocations_per_op = double(AllocationCounter::count() - allocations) / nops;
+    std::cout << "  " << std::left << std::setw(44) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << result.ns_per_op << " ns/op";
+    if(evals_per_op > 0) std::cout << std::setw(14) << std::setprecision(0) << result.evals_per_second << " evals/s";
+    if(AllocationCounter::enabled()) std::cout << std::setw(10) << std::setprecision(2) << result.allocations_per_op << " allocs/op";
+    std::cout << std::endl;
+    return result;
+}
+
+void write_results(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream out(path.c_str());
+    out << "[" << std::endl;
+    for(size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "  {\"name\": \"" << r.name << "\", \"ops\": " << r.nops << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"evals_per_second\": " << r.evals_per_second;
+        if(AllocationCounter::enabled()) out << ", \"allocations_per_op\": " << r.allocations_per_op;
+        out << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    out << "]" << std::endl;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "bench_results.json";
+    double seconds = argc > 2 ? std::atof(argv[2]) : 0.5e0;
+
+    // the same random 7 card hands for every benchmark and every build
+    Xoshiro256 rng(2016);
+    std::vector<std::vector<Card>> hands(NHANDS);
+    std::vector<std::vector<std::vector<Card>>> subsets(NHANDS);
+    for(int i = 0; i < NHANDS; ++i) {
+        uint64_t used = 0;
+        while(hands[i].size() < 7) {
+            int c = static_cast<int>(rng.bounded(Card::NUM_CARDS));
+            if(used & (uint64_t(1) << c)) continue;
+            used |= uint64_t(1) << c;
+            hands[i].push_back(Card::from_index(c));
+        }
+        subsets[i] = combinations(hands[i], 5);
+    }
+    Deck remaining;
+    for(int i = 0; i < 7; ++i) remaining.delete_card(hands[0][i]);
+
+    std::vector<Result> results;
+    std::cout << "Benchmarks (" << seconds << " s each)" << std::endl;
+    results.push_back(measure("HandEvaluator::evaluate 7 cards", 1, seconds, [&](long long i) {
+        return HandEvaluator::evaluate(hands[i % NHANDS]);
+    }));
+    // every kernel the CPU has, checked against the scalar one first
+    std::vector<Card> packed;
+    for(const std::vector<Card>& hand: hands) packed.insert(std::end(packed), std::begin(hand), std::end(hand));
+    std::vector<int> batch_strengths(NHANDS);
+    // and every pair of the 45 cards left around the first hand's board, the way enumeration scores them
+    HandEvaluator::State board_state = HandEvaluator::state(&hands[0][2], 5);
+    std::vector<Card> pair_cards;
+    for(size_t i = 0; i < remaining.get_deck().size(); ++i) {
+        for(size_t j = i + 1; j < remaining.get_deck().size(); ++j) {
+            pair_cards.push_back(remaining.get_deck()[i]);
+            pair_cards.push_back(remaining.get_deck()[j]);
+        }
+    }
+    // the same hands as finished states, the way TrialEngine::run() scores them
+    std::vector<uint64_t> state_keys, state_masks;
+    for(const std::vector<Card>& hand: hands) {
+        HandEvaluator::State state = HandEvaluator::state(hand.data(), 7);
+        state_keys.push_back(state.key);
+        state_masks.push_back(state.mask);
+    }
+    BatchEvaluator::Kernel picked = BatchEvaluator::kernel();
+    BatchEvaluator::Kernel picked_states = BatchEvaluator::states_kernel();
+    std::cout << "  kernels picked: " << BatchEvaluator::name(picked) << " for cards, "
+              << BatchEvaluator::name(picked_states) << " for states" << std::endl;
+    for(BatchEvaluator::Kernel kernel: {BatchEvaluator::SCALAR, BatchEvaluator::AVX2, BatchEvaluator::AVX512}) {
+        if(!BatchEvaluator::supported(kernel)) continue;
+        std::string name = BatchEvaluator::name(kernel);
+        if(!BatchEvaluator::check(kernel, 10000, 2016)) std::cout << "  " << name << " kernel disagrees with scalar!" << std::endl;
+        BatchEvaluator::set_kernel(kernel);
+        results.push_back(measure("BatchEvaluator " + name + " " + std::to_string(NHANDS) + " x 7 cards", NHANDS, seconds,
+                                  [&](long long) {
+            BatchEvaluator::evaluate(packed.data(), 7, NHANDS, batch_strengths.data());
+            return static_cast<long long>(batch_strengths[0]);
+        }));
+        results.push_back(measure("BatchEvaluator " + name + " board + 990 x 2 cards", 990, seconds, [&](long long) {
+            BatchEvaluator::evaluate(board_state, pair_cards.data(), 2, 990, batch_strengths.data());
+            return static_cast<long long>(batch_strengths[0]);
+        }));
+        results.push_back(measure("BatchEvaluator " + name + " " + std::to_string(NHANDS) + " x 7 card states", NHANDS,
+                                  seconds, [&](long long) {
+            BatchEvaluator::evaluate_states(state_keys.data(), state_masks.data(), 7, NHANDS, batch_strengths.data());
+            return static_cast<long long>(batch_strengths[0]);
+        }));
+    }
+    BatchEvaluator::set_kernel(picked, picked_states);
+    results.push_back(measure("PokerHand 7 cards + score_hand", 1, seconds, [&](long long i) {
+        PokerHand hand(hands[i % NHANDS]);
+        hand.score_hand();
+        return hand.get_strength();
+    }));
+    results.push_back(measure("Hand 7 cards + score", 1, seconds, [&](long long i) {
+        Hand hand = Hand::make(hands[i % NHANDS]);
+        return static_cast<long long>(hand.score());
+    }));
+    results.push_back(measure("PokerGame::find_best_hand 21 x 5 cards", 21, seconds, [&](long long i) {
+        return PokerGame::find_best_hand(subsets[i % NHANDS]).get_strength();
+    }));
+    results.push_back(measure("combinations 7 choose 5", 0, seconds, [&](long long i) {
+        return static_cast<long long>(combinations(hands[i % NHANDS], 5).size());
+    }));
+    results.push_back(measure("combinations 45 choose 2", 0, seconds, [&](long long) {
+        return static_cast<long long>(combinations(remaining.get_deck(), 2).size());
+    }));
+    results.push_back(measure("for_each_combination 7 choose 5", 0, seconds, [&](long long i) {
+        long long total = 0;
+        for_each_combination(hands[i % NHANDS], 5, [&total](const Card* subset, int) { total += subset[0].get_index(); });
+        return total;
+    }));
+    results.push_back(measure("for_each_combination 45 choose 2", 0, seconds, [&](long long) {
+        long long total = 0;
+        for_each_combination(remaining.get_deck(), 2, [&total](const Card* subset, int) { total += subset[1].get_index(); });
+        return total;
+    }));
+    // every turn and river of a flop for two hands, the way enumeration walks runouts
+    const Card* flop = &hands[0][2];
+    Card villain[2] = {remaining.get_deck()[0], remaining.get_deck()[1]};
+    std::vector<Card> runout_cards(remaining.get_deck().begin() + 2, remaining.get_deck().end());
+    int nrunout_cards = static_cast<int>(runout_cards.size());
+    HandEvaluator::State flop_state = HandEvaluator::state(flop, 3);
+    results.push_back(measure("flop runouts 43 choose 2, CombinationIterator + rebuilt board", 2 * 903, seconds,
+                              [&](long long) {
+        long long total = 0;
+        for(CombinationIterator it(nrunout_cards, 2); !it.done(); it.next()) {
+            HandEvaluator::State board = flop_state;
+            for(uint64_t m = it.mask(); m; m &= m - 1) board = HandEvaluator::add(board, runout_cards[__builtin_ctzll(m)]);
+            total += HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board, hands[0][0]), hands[0][1]));
+            total += HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board, villain[0]), villain[1]));
+        }
+        return total;
+    }));
+    results.push_back(measure("flop runouts 43 choose 2, RevolvingDoorIterator + board delta", 2 * 903, seconds,
+                              [&](long long) {
+        long long total = 0;
+        RevolvingDoorIterator it(nrunout_cards, 2);
+        HandEvaluator::State board = flop_state;
+        for(uint64_t m = it.mask(); m; m &= m - 1) board = HandEvaluator::add(board, runout_cards[__builtin_ctzll(m)]);
+        for(; !it.done(); it.next()) {
+            if(it.removed() >= 0) {
+                board = HandEvaluator::add(HandEvaluator::remove(board, runout_cards[it.removed()]), runout_cards[it.added()]);
+            }
+            total += HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board, hands[0][0]), hands[0][1]));
+            total += HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board, villain[0]), villain[1]));
+        }
+        return total;
+    }));
+    Deck deck;
+    results.push_back(measure("Deck::repopulate", 0, seconds, [&](long long) {
+        deck.repopulate();
+        return deck.size();
+    }));
+    results.push_back(measure("Deck::repopulate + 9 x draw_delete_rand_card", 0, seconds, [&](long long) {
+        deck.repopulate();
+        long long total = 0;
+        for(int k = 0; k < 9; ++k) total += deck.draw_delete_rand_card().get_index();
+        return total;
+    }));
+    // the same deal from a 64 bit card set: the dead cards are a mask, the reset is one copy
+    CardSet start = CardSet::deck(CardSet(hands[0]).mask());
+    Xoshiro256 deal_rng(2016);
+    results.push_back(measure("CardSet reset + 9 x deal", 0, seconds, [&](long long) {
+        CardSet live = start;
+        long long total = 0;
+        for(int k = 0; k < 9; ++k) total += live.deal(deal_rng).get_index();
+        return total;
+    }));
+    results.push_back(measure("CardSet::select", 0, seconds, [&](long long i) {
+        return static_cast<long long>(start.select(static_cast<int>(i % start.size())).get_index());
+    }));
+    std::vector<Card> hole_cards = {Card(0, 12), Card(0, 11)};
+    for(int nplayers: {2, 6, 10}) {
+        TrialEngine engine(Deck(), hole_cards, std::vector<Card>(), nplayers, 2016, 0);
+        results.push_back(measure("TrialEngine::run_trial " + std::to_string(nplayers) + " players", nplayers, seconds,
+                                  [&](long long) {
+            engine.run_trial();
+            return engine.tally(0).wins;
+        }));
+        results.push_back(measure("TrialEngine::run 256 trials " + std::to_string(nplayers) + " players", 256 * nplayers,
+                                  seconds, [&](long long) {
+            engine.run(256);
+            return engine.tally(0).wins;
+        }));
+    }
+    write_results(path, results);
+    std::cout << "wrote " << path << std::endl;
+    return 0;
+}
@@ -0,0 +1,3 @@
+# builds the benchmarks against the calculator's sources (everything but main.cpp).
+# add -DPOKER_COUNT_ALLOCATIONS to also report heap allocations per op.
+g++ $(ls ../*.cpp | grep -v '/main.cpp$') bench.cpp -I.. -lpthread -O3 -std=c++11 -o bench "$@"
@@ -7,44 +7,38 @@
 //
 
 #include <algorithm>
+#include <cctype>
 
 #include "card.hpp"
 
+const char* const Card::STR_SUITS_[Card::NUM_SUITS] = {"s", "c", "h", "d"};
+const char* const Card::STR_RANKS_[Card::NUM_RANKS] = {"2", "3", "4", "5", "6", "7", "8", "9", "T", "J", "Q", "K", "A"};
 
-Card::Card() {
-    
+Card Card::from_index(int index) {
+    Card c;
+    c.index_ = static_cast<uint8_t>(index);
+    return c;
 }
 
-Card::~Card() {
-    
-}
-
-Card::Card(int suit, int rank) {
-    suit_ = suit;
-    rank_ = rank;
-    str_suit_ = "";
-    str_rank_ = "";
-}
-
-Card::Card(int suit, int rank, std::string str_suit, std::string str_rank) {
-    suit_ = suit;
-    rank_ = rank;
-    str_suit_ = str_suit;
-    str_rank_ = str_rank;
-}
-
-int Card::get_rank() const {
-    return rank_;
-}
-
-int Card::get_suit() const {
-    return suit_;
+/* reads a card written as rank then suit, e.g. "Th" or "as", false if str isn't one */
+bool Card::from_str(const std::string& str, Card& card) {
+    if(str.size() != 2) return false;
+    int rank = -1, suit = -1;
+    for(int r = 0; r < NUM_RANKS; ++r) {
+        if(std::toupper(str[0]) == STR_RANKS_[r][0]) rank = r;
+    }
+    for(int s = 0; s < NUM_SUITS; ++s) {
+        if(std::tolower(str[1]) == STR_SUITS_[s][0]) suit = s;
+    }
+    if(rank < 0 || suit < 0) return false;
+    card = Card(suit, rank);
+    return true;
 }
 
 bool Card::operator<(const Card& rhs) const {
-    if(!order_suits_) return rank_ < rhs.get_rank();
-    if(suit_ != rhs.get_suit()) return suit_ < rhs.get_suit();
-    return rank_ < rhs.get_rank();
+    if(!order_suits_) return get_rank() < rhs.get_rank();
+    if(get_suit() != rhs.get_suit()) return get_suit() < rhs.get_suit();
+    return get_rank() < rhs.get_rank();
 }
 
 bool Card::operator>(const Card& rhs) const {
@@ -52,7 +46,7 @@ bool Card::operator>(const Card& rhs) const {
 }
 
 bool Card::operator==(const Card& rhs) const {
-    return (suit_ == rhs.get_suit() && rank_ == rhs.get_rank());
+    return index_ == rhs.index_;
 }
 
 bool Card::operator!=(const Card& rhs) const {
@@ -67,24 +61,14 @@ bool Card::operator>=(const Card& rhs) const {
     return (*this > rhs || *this == rhs);
 }
 
-void Card::operator=(const Card& rhs) {
-    suit_ = rhs.get_suit();
-    rank_ = rhs.get_rank();
-    str_suit_ = rhs.get_str_suit();
-    str_rank_ = rhs.get_str_rank();
-}
-
 std::string Card::get_str_suit() const {
-    if(str_suit_ != "") return str_suit_;
-    return std::to_string((suit_));
+    return STR_SUITS_[get_suit()];
 }
 
 std::string Card::get_str_rank() const {
-    if(str_rank_ != "") return str_rank_;
-    return std::to_string((rank_));
+    return STR_RANKS_[get_rank()];
 }
 
 std::string Card::str() const {
-    //std::string str_card = RANKS_[rank_] + SUITS_[suit_];
     return get_str_rank() + get_str_suit();
 }
@@ -12,35 +12,45 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <type_traits>
 
+/* a card is a single byte holding its index 0..51 (rank * 4 + suit).  the
+   rank and suit strings only exist in static tables and are looked up when
+   the card is printed, so cards are trivially copyable on the hot path. */
 class Card {
 public:
     // Card(unsigned int suit, unsigned int rank, const bool order_suits);
-    Card();
-    Card(int suit, int rank);
-    Card(int suit, int rank, std::string str_suit, std::string str_rank);
+    Card() : index_(0) { }
+    Card(int suit, int rank) : index_(static_cast<uint8_t>(rank * NUM_SUITS + suit)) { }
     // Card(std::string str_suit, std::string str_rank);
-    ~Card();
-    int get_suit() const;
-    int get_rank() const;
+    static Card from_index(int index);
+    static bool from_str(const std::string& str, Card& card);
+    int get_suit() const { return index_ % NUM_SUITS; }
+    int get_rank() const { return index_ / NUM_SUITS; }
+    int get_index() const { return index_; }
     bool operator<(const Card& rhs) const;
     bool operator>(const Card& rhs) const;
     bool operator<=(const Card& rhs) const;
     bool operator>=(const Card& rhs) const;
     bool operator==(const Card& rhs) const;
     bool operator!=(const Card& rhs) const;
-    void operator=(const Card& rhs);
     std::string str() const;
     std::string get_str_suit() const;
     std::string get_str_rank() const;
+    static const int NUM_SUITS = 4;
+    static const int NUM_RANKS = 13;
+    static const int NUM_CARDS = NUM_SUITS * NUM_RANKS;
 private:
-    int suit_;
-    int rank_;
-    std::string str_suit_;
-    std::string str_rank_;
+    uint8_t index_;
     static const bool order_suits_ = false;
+    static const char* const STR_SUITS_[NUM_SUITS];
+    static const char* const STR_RANKS_[NUM_RANKS];
 };
 
+static_assert(sizeof(Card) == 1, "Card must stay a single byte");
+static_assert(std::is_trivially_copyable<Card>::value, "Card must stay trivially copyable");
+
 //bool cmp(const Card& lhs, const Card& rhs);
 
 
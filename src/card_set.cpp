@@ -0,0 +1,25 @@
+//
+//  card_set.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include "card_set.hpp"
+
+/* the cards in index order */
+std::vector<Card> CardSet::cards() const {
+    std::vector<Card> cards;
+    cards.reserve(size());
+    for(uint64_t m = mask_; m; m &= m - 1) cards.push_back(Card::from_index(__builtin_ctzll(m)));
+    return cards;
+}
+
+std::string CardSet::str() const {
+    std::string ans = "";
+    for(uint64_t m = mask_; m; m &= m - 1) {
+        if(!ans.empty()) ans += " ";
+        ans += Card::from_index(__builtin_ctzll(m)).str();
+    }
+    return ans;
+}
@@ -0,0 +1,178 @@
+//
+//  card_set.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef card_set_hpp
+#define card_set_hpp
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CARD_SET_X86_BITS 1
+#include <immintrin.h>
+#endif
+
+#include "card.hpp"
+#include "rng.hpp"
+
+/* a set of cards in one 64 bit word, bit number = card index.  add, remove
+   and contains are a single bit operation, size() is a popcount and
+   select(i) finds the i-th card left in index order.  folded or exposed
+   cards are just a dead mask taken out of the full deck, and a deck is
+   reset for the next trial by copying the word back.
+
+   the build doesn't assume BMI2 or popcnt, so on x86-64 size(), select()
+   and deal() check the CPU once (like BatchEvaluator picks its kernel) and
+   go through versions compiled for popcnt and pdep when it has them.
+   anywhere else select() skips over 16 bit blocks by popcount. */
+class CardSet
+{
+public:
+    static const uint64_t FULL_DECK = (uint64_t(1) << Card::NUM_CARDS) - 1;
+    CardSet() : mask_(0) { }
+    explicit CardSet(uint64_t mask) : mask_(mask) { }
+    explicit CardSet(const std::vector<Card>& cards);
+    static CardSet deck(uint64_t dead = 0);
+    void add(const Card& c);
+    void add(const CardSet& cards);
+    void remove(const Card& c);
+    void remove(const CardSet& cards);
+    bool contains(const Card& c) const;
+    bool intersects(const CardSet& cards) const;
+    int size() const;
+    bool empty() const;
+    uint64_t mask() const;
+    Card select(int i) const;
+    Card deal(Xoshiro256& rng);
+    std::vector<Card> cards() const;
+    std::string str() const;
+private:
+    uint64_t mask_;
+    static uint64_t bit(const Card& c);
+    static bool fast_bits();
+#ifdef CARD_SET_X86_BITS
+    __attribute__((target("popcnt"))) int size_popcnt() const;
+    __attribute__((target("bmi2,popcnt"))) Card select_bmi2(int i) const;
+    __attribute__((target("bmi2,popcnt"))) Card deal_bmi2(Xoshiro256& rng);
+#endif
+};
+
+inline CardSet::CardSet(const std::vector<Card>& cards) : mask_(0) {
+    for(const Card& c: cards) mask_ |= bit(c);
+}
+
+/* every card but the dead ones */
+inline CardSet CardSet::deck(uint64_t dead) {
+    return CardSet(FULL_DECK & ~dead);
+}
+
+inline uint64_t CardSet::bit(const Card& c) {
+    return uint64_t(1) << c.get_index();
+}
+
+inline void CardSet::add(const Card& c) {
+    mask_ |= bit(c);
+}
+
+inline void CardSet::add(const CardSet& cards) {
+    mask_ |= cards.mask_;
+}
+
+inline void CardSet::remove(const Card& c) {
+    mask_ &= ~bit(c);
+}
+
+inline void CardSet::remove(const CardSet& cards) {
+    mask_ &= ~cards.mask_;
+}
+
+inline bool CardSet::contains(const Card& c) const {
+    return (mask_ & bit(c)) != 0;
+}
+
+inline bool CardSet::intersects(const CardSet& cards) const {
+    return (mask_ & cards.mask_) != 0;
+}
+
+/* true if size(), select() and deal() can use popcnt and pdep, asked of
+   the CPU on first use */
+inline bool CardSet::fast_bits() {
+#if defined(__BMI2__) && defined(__POPCNT__)
+    return true;
+#elif defined(CARD_SET_X86_BITS)
+    static const bool fast = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("popcnt");
+    }();
+    return fast;
+#else
+    return false;
+#endif
+}
+
+inline int CardSet::size() const {
+#ifdef CARD_SET_X86_BITS
+    if(fast_bits()) return size_popcnt();
+#endif
+    return __builtin_popcountll(mask_);
+}
+
+inline bool CardSet::empty() const {
+    return mask_ == 0;
+}
+
+inline uint64_t CardSet::mask() const {
+    return mask_;
+}
+
+/* the card of rank i (from 0) among the cards in the set, i < size() */
+inline Card CardSet::select(int i) const {
+#ifdef CARD_SET_X86_BITS
+    if(fast_bits()) return select_bmi2(i);
+#endif
+    uint64_t m = mask_;
+    int base = 0;
+    for(int n = __builtin_popcountll(m & 0xffff); i >= n; n = __builtin_popcountll(m & 0xffff)) {
+        i -= n;
+        m >>= 16;
+        base += 16;
+    }
+    for(; i > 0; --i) m &= m - 1;
+    return Card::from_index(base + __builtin_ctzll(m));
+}
+
+/* takes a uniformly random card out of the set, which must not be empty */
+inline Card CardSet::deal(Xoshiro256& rng) {
+#ifdef CARD_SET_X86_BITS
+    if(fast_bits()) return deal_bmi2(rng);
+#endif
+    Card c = select(static_cast<int>(rng.bounded(static_cast<uint32_t>(size()))));
+    remove(c);
+    return c;
+}
+
+#ifdef CARD_SET_X86_BITS
+inline int CardSet::size_popcnt() const {
+    return __builtin_popcountll(mask_);
+}
+
+/* pdep puts the i-th lowest set bit of mask_ where the only set bit of 1 << i is */
+inline Card CardSet::select_bmi2(int i) const {
+    return Card::from_index(__builtin_ctzll(_pdep_u64(uint64_t(1) << i, mask_)));
+}
+
+/* deal() with size and select done right here, so they are inlined */
+inline Card CardSet::deal_bmi2(Xoshiro256& rng) {
+    uint64_t pick = uint64_t(1) << rng.bounded(static_cast<uint32_t>(__builtin_popcountll(mask_)));
+    uint64_t card = _pdep_u64(pick, mask_);
+    mask_ &= ~card;
+    return Card::from_index(__builtin_ctzll(card));
+}
+#endif
+
+#endif /* card_set_hpp */
@@ -1,2 +1,8 @@
-rm a.out
-g++ *.cpp -lpthread -O3 -std=c++11
+rm -f a.out libpoker.a
+# the engine library: everything but the console and batch front ends
+LIB_SOURCES=$(ls *.cpp | grep -v -e '^main.cpp$' -e '^poker_game.cpp$' -e '^batch_runner.cpp$')
+mkdir -p obj
+for f in $LIB_SOURCES; do g++ -c $f -O3 -std=c++11 -o obj/${f%.cpp}.o; done
+ar rcs libpoker.a obj/*.o
+rm -r obj
+g++ main.cpp poker_game.cpp batch_runner.cpp libpoker.a -lpthread -O3 -std=c++11
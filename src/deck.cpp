@@ -40,40 +40,62 @@ Deck::~Deck() {
 
 void Deck::sort() {
     std::sort(deck_.begin(), deck_.end());
+    index_slots();
 }
 
 void Deck::shuffle() {
     std::shuffle(std::begin(deck_), std::end(deck_), rand_eng_);
+    index_slots();
+}
+
+/* where every card sits in deck_, after anything that moves them around */
+void Deck::index_slots() {
+    for(size_t i = 0; i < deck_.size(); ++i) slots_[deck_[i].get_index()] = static_cast<int8_t>(i);
 }
 
 Card Deck::draw_delete_back() {
     Card tmp = deck_.back();
     deck_.pop_back();
+    cards_.remove(tmp);
     return tmp;
 }
 
 Card Deck::draw_delete_front() {
     Card c = deck_.front();
     deck_.erase(std::begin(deck_));
+    cards_.remove(c);
+    index_slots();
     return c;
 }
 
 void Deck::add_back(const Card& c) {
-    if(!find(c)) deck_.push_back(c);
+    if(find(c)) return;
+    slots_[c.get_index()] = static_cast<int8_t>(deck_.size());
+    deck_.push_back(c);
+    cards_.add(c);
 }
 
 void Deck::add_front(const Card& c) {
-    if(!find(c)) deck_.insert(std::begin(deck_), c);
+    if(find(c)) return;
+    deck_.insert(std::begin(deck_), c);
+    cards_.add(c);
+    index_slots();
 }
 
 bool Deck::find(const Card& c) const {
-    return std::find(std::begin(deck_), std::end(deck_), c) != std::end(deck_);
+    return c.get_index() < Card::NUM_CARDS && cards_.contains(c);
 }
 
+/* the last card takes the deleted one's place, so this doesn't keep the
+   order; draw_delete_front() and draw_delete_back() do */
 void Deck::delete_card(const Card& c) {
-    std::vector<Card>::iterator pos;
-    pos = std::find(std::begin(deck_), std::end(deck_), c);
-    if(pos != std::end(deck_)) deck_.erase(pos);
+    if(!find(c)) return;
+    // c may be one of deck_'s own cards, so take it out of the mirror first
+    cards_.remove(c);
+    int slot = slots_[c.get_index()];
+    deck_[slot] = deck_.back();
+    slots_[deck_[slot].get_index()] = static_cast<int8_t>(slot);
+    deck_.pop_back();
 }
 
 void Deck::show(const std::vector<Card>& hand) {
@@ -92,7 +114,7 @@ std::string Deck::display_card(const Card& c) {
 }
 
 long Deck::size() const {
-    return deck_.size();
+    return cards_.size();
 }
 
 Card Deck::draw_delete_rand_card() {
@@ -102,10 +124,14 @@ Card Deck::draw_delete_rand_card() {
     return c;
 }
 
-const std::vector<Card>& Deck::get_deck() {
+const std::vector<Card>& Deck::get_deck() const {
     return deck_;
 }
 
+const CardSet& Deck::card_set() const {
+    return cards_;
+}
+
 void Deck::add_front(const std::vector<Card> &c) {
     for(const Card& i: c) {
         add_front(i);
@@ -120,6 +146,7 @@ void Deck::add_back(const std::vector<Card> &c) {
 
 void Deck::clear() {
     deck_.clear();
+    cards_ = CardSet();
 }
 
 bool Deck::empty() {
@@ -130,14 +157,14 @@ void Deck::repopulate() {
     clear();
     for(int isuit = 0; isuit < SUITS_.size(); isuit++) {
         for(int irank=0; irank < RANKS_.size(); irank++) {
-            // Card c(isuit, irank, SUITS_[isuit], RANKS_[irank]);
-            Card c(isuit, irank, SUITS_[isuit], RANKS_[irank]);
-            deck_.push_back(c);
+            deck_.push_back(Card(isuit, irank));
         }
     }
+    cards_ = CardSet::deck();
+    index_slots();
 }
 
-std::string Deck::str() {
+std::string Deck::str() const {
     std::string ans = "";
     int i = 0;
     for(const Card& c: deck_) {
@@ -176,6 +203,6 @@ Card Deck::generate_card(const std::string& suit, const std::string& rank) const
     std::vector<std::string>::const_iterator it_rank = std::find(std::begin(RANKS_), std::end(RANKS_), rank);
     int isuit = std::distance(std::begin(SUITS_), it_suit);
     int irank = std::distance(std::begin(RANKS_), it_rank);
-    Card c(isuit, irank, SUITS_[isuit], RANKS_[irank]);
+    Card c(isuit, irank);
     return c;
 }
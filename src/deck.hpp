@@ -14,9 +14,16 @@
 #include <vector>
 #include <random>
 #include <chrono>
+#include <cstdint>
 
 #include "card.hpp"
+#include "card_set.hpp"
 
+/* the cards left, in order.  which cards are in it is mirrored in a
+   CardSet, so find(), size() and card_set() don't scan the vector, and
+   slots_ keeps where each card sits in it, so delete_card() swaps the last
+   card into the hole instead of searching and shifting.  the vector, the
+   mirror and the slots are private so they can't get out of step. */
 class Deck {
 public:
     Deck();
@@ -30,7 +37,7 @@ public:
     Card draw_delete_card(const Card& c);
     Card draw_delete_card(const std::string& suit, const std::string& rank);
     Card generate_card(const std::string& suit, const std::string& rank) const;
-    const std::vector<Card>& get_deck();
+    const std::vector<Card>& get_deck() const;
     void delete_card(const Card& c);
     void delete_card(const std::string& suit, const std::string& rank);
     void add_front(const Card& c);
@@ -41,18 +48,23 @@ public:
     void add_back(const std::string& suit, const std::string& rank);
     bool find(const Card& c) const;
     bool find(const std::string& suit, const std::string& rank) const;
+    const CardSet& card_set() const;
     static void show(const std::vector<Card>& hand);
     static std::string display_card(const Card& c);
     long size() const;
     void repopulate();
     void clear();
     bool empty();
-    std::string str();
+    std::string str() const;
 protected:
-    std::vector<Card> deck_;
     std::default_random_engine rand_eng_;
     static const std::vector<std::string> SUITS_;
     static const std::vector<std::string> RANKS_;
+private:
+    std::vector<Card> deck_;
+    CardSet cards_;
+    int8_t slots_[Card::NUM_CARDS];
+    void index_slots();
 };
 
 
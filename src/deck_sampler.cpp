@@ -0,0 +1,61 @@
+//
+//  deck_sampler.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <ctime>
+
+#include "deck_sampler.hpp"
+
+DeckSampler::DeckSampler() {
+    ncards_ = 0;
+    ndealt_ = 0;
+    for(int i = 0; i < Card::NUM_CARDS; ++i) {
+        slots_[i] = static_cast<int8_t>(ncards_);
+        cards_[ncards_++] = Card::from_index(i);
+    }
+    rng_.seed(time(0));
+}
+
+DeckSampler::DeckSampler(const Deck& deck) {
+    ncards_ = 0;
+    ndealt_ = 0;
+    for(int i = 0; i < Card::NUM_CARDS; ++i) slots_[i] = -1;
+    for(const Card& c: deck.get_deck()) {
+        slots_[c.get_index()] = static_cast<int8_t>(ncards_);
+        cards_[ncards_++] = c;
+    }
+    rng_.seed(time(0));
+}
+
+void DeckSampler::seed(uint64_t seed_value) {
+    rng_.seed(seed_value);
+}
+
+void DeckSampler::set_rng(const Xoshiro256& rng) {
+    rng_ = rng;
+}
+
+/* takes a known card out of the deck for good, linear but only done at setup */
+void DeckSampler::remove(const Card& c) {
+    undo_all();
+    for(int i = 0; i < ncards_; ++i) {
+        if(cards_[i] == c) {
+            cards_[i] = cards_[--ncards_];
+            slots_[cards_[i].get_index()] = static_cast<int8_t>(i);
+            slots_[c.get_index()] = -1;
+            return;
+        }
+    }
+}
+
+/* undealt cards left */
+int DeckSampler::size() const {
+    return ncards_ - ndealt_;
+}
+
+int DeckSampler::ndealt() const {
+    return ndealt_;
+}
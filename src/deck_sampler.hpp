@@ -0,0 +1,71 @@
+//
+//  deck_sampler.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef deck_sampler_hpp
+#define deck_sampler_hpp
+
+#include "card.hpp"
+#include "deck.hpp"
+#include "rng.hpp"
+
+/* deals random cards by partial Fisher-Yates on a fixed array.  dealt cards
+   are swapped to the front, so a deal is one bounded draw and one swap, and
+   undo_all() just forgets them: the order of the undealt cards does not
+   matter for the next uniform draw.  every card's slot is tracked as well,
+   so deal_card() can take a given card (e.g. from a range) in O(1) too. */
+class DeckSampler
+{
+public:
+    DeckSampler();
+    explicit DeckSampler(const Deck& deck);
+    void seed(uint64_t seed_value);
+    void set_rng(const Xoshiro256& rng);
+    void remove(const Card& c);
+    Card deal();
+    void deal_card(const Card& c);
+    void undo_all();
+    Xoshiro256& rng();
+    int size() const;
+    int ndealt() const;
+private:
+    Card cards_[Card::NUM_CARDS];
+    int8_t slots_[Card::NUM_CARDS];
+    int ncards_;
+    int ndealt_;
+    Xoshiro256 rng_;
+};
+
+inline Card DeckSampler::deal() {
+    int pick = ndealt_ + static_cast<int>(rng_.bounded(static_cast<uint32_t>(ncards_ - ndealt_)));
+    Card c = cards_[pick];
+    Card swapped = cards_[ndealt_];
+    cards_[pick] = swapped;
+    slots_[swapped.get_index()] = static_cast<int8_t>(pick);
+    slots_[c.get_index()] = static_cast<int8_t>(ndealt_);
+    cards_[ndealt_++] = c;
+    return c;
+}
+
+/* deals a card that must still be undealt */
+inline void DeckSampler::deal_card(const Card& c) {
+    int pick = slots_[c.get_index()];
+    Card swapped = cards_[ndealt_];
+    cards_[pick] = swapped;
+    slots_[swapped.get_index()] = static_cast<int8_t>(pick);
+    slots_[c.get_index()] = static_cast<int8_t>(ndealt_);
+    cards_[ndealt_++] = c;
+}
+
+inline void DeckSampler::undo_all() {
+    ndealt_ = 0;
+}
+
+inline Xoshiro256& DeckSampler::rng() {
+    return rng_;
+}
+
+#endif /* deck_sampler_hpp */
@@ -0,0 +1,536 @@
+//
+//  equity_engine.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "equity_engine.hpp"
+#include "deck.hpp"
+#include "misc.hpp"
+#include "hand_evaluator.hpp"
+#include "batch_evaluator.hpp"
+#include "suit_isomorphism.hpp"
+#include "card_set.hpp"
+
+// definitions for the in-class constants, so passing them by reference (std::min) links at any -O
+const long EquityEngine::TRIALS_PER_CHUNK_;
+const long EquityEngine::RUNOUTS_PER_CHUNK_;
+const long EquityEngine::MIN_CHUNKS_PER_BATCH_;
+const long EquityEngine::MAX_CHUNKS_PER_BATCH_;
+
+EquityQuery::EquityQuery() {
+    nplayers = 2;
+    max_trials = 100000000;
+    max_seconds = 10.0e0;
+    target_half_width = 0.005e0;
+    max_showdowns = 200000000;
+    seed = 0;
+}
+
+EquityResult::EquityResult() {
+    method = NONE;
+    win = 0.0e0;
+    tie = 0.0e0;
+    equity = 0.0e0;
+    variance = 0.0e0;
+    half_width = 0.0e0;
+    nsamples = 0;
+    nrunouts = 0;
+    nallocations = 0;
+    seconds = 0.0e0;
+    counts = ShowdownCounts{0, 0, 0, 0.0e0};
+}
+
+EquityEngine::EquityEngine(ThreadPool& pool, const PreflopTable* preflop_table)
+    : pool_(pool), preflop_table_(preflop_table) { }
+
+/* the cheapest exact answer there is, or Monte Carlo when there is none */
+EquityResult EquityEngine::calculate(const EquityQuery& query) const {
+    EquityResult result = lookup_preflop(query);
+    if(result.method == EquityResult::NONE) result = enumerate(query);
+    if(result.method == EquityResult::NONE && validate(query).empty()) result = monte_carlo(query);
+    return result;
+}
+
+/* empty if the query can be answered, what is wrong with it otherwise */
+std::string EquityEngine::validate(const EquityQuery& query) const {
+    if(query.hole_cards.size() != 2) return "seat 0 needs two hole cards";
+    size_t nboard = query.board.size();
+    if(nboard == 1 || nboard == 2 || nboard > 5) return "a board has 0, 3, 4 or 5 cards";
+    if(query.nplayers < 2 || query.nplayers > TrialEngine::MAX_PLAYERS) return "there must be 2 to 10 players";
+    if(query.ranges.size() > size_t(query.nplayers)) return "more ranges than players";
+    if(query.max_trials < 1) return "max_trials must be at least 1";
+    CardSet known;
+    for(const std::vector<Card>* cards: {&query.hole_cards, &query.board, &query.dead_cards}) {
+        for(const Card& c: *cards) {
+            if(known.contains(c)) return c.str() + " appears twice";
+            known.add(c);
+        }
+    }
+    if(Card::NUM_CARDS - known.size() < 2 * (query.nplayers - 1) + 5 - int(nboard)) return "not enough cards left to deal";
+    return "";
+}
+
+bool EquityEngine::has_ranges(const EquityQuery& query) const {
+    for(const HandRange& range: query.ranges) {
+        if(!range.empty()) return true;
+    }
+    return false;
+}
+
+/* all-in preflop against random hands, straight from the table */
+EquityResult EquityEngine::lookup_preflop(const EquityQuery& query) const {
+    EquityResult result;
+    if(!preflop_table_ || !preflop_table_->loaded()) {
+        result.error = "no preflop table";
+        return result;
+    }
+    if(!query.board.empty() || !query.dead_cards.empty() || has_ranges(query)) {
+        result.error = "not a preflop question against random hands";
+        return result;
+    }
+    result.error = validate(query);
+    if(!result.error.empty()) return result;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    result.equity = preflop_table_->equity_vs_random(query.hole_cards[0], query.hole_cards[1], query.nplayers);
+    result.method = EquityResult::PREFLOP_TABLE;
+    result.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+    return result;
+}
+
+/* every board and every set of opponent hands, if there are at most max_showdowns of them */
+EquityResult EquityEngine::enumerate(const EquityQuery& query) const {
+    return enumerate_range(query, 0, std::numeric_limits<uint64_t>::max());
+}
+
+/* the runouts numbered first to last - 1 (see runout()) and every set of
+   opponent hands against each.  ranges can be run in any order, on any
+   machine: adding up their counts gives the same result as enumerate().
+   max_showdowns applies to the range. */
+EquityResult EquityEngine::enumerate_range(const EquityQuery& query, uint64_t first, uint64_t last) const {
+    EquityResult result;
+    result.error = validate(query);
+    if(!result.error.empty()) return result;
+    if(has_ranges(query)) {
+        result.error = "ranges can't be enumerated";
+        return result;
+    }
+    auto t0 = std::chrono::high_resolution_clock::now();
+    int nopponents = query.nplayers - 1;
+    int board_cards_left = 5 - static_cast<int>(query.board.size());
+    std::vector<Card> remaining = remaining_cards(query);
+    uint64_t nrunouts = binomial(static_cast<int>(remaining.size()), board_cards_left);
+    last = std::min(last, nrunouts);
+    first = std::min(first, last);
+    double nshowdowns = count_showdowns(static_cast<int>(remaining.size()), board_cards_left, nopponents)
+                        * double(last - first) / double(nrunouts);
+    if(nshowdowns > query.max_showdowns) {
+        result.error = "too many showdowns to enumerate";
+        result.nsamples = static_cast<long long>(nshowdowns);
+        return result;
+    }
+    // every worker unranks the start of its own index range, nothing is shared but the counts
+    std::vector<int> symmetries = board_symmetries(query);
+    int nslots = pool_.size() + 1;
+    long nchunks = static_cast<long>((last - first + RUNOUTS_PER_CHUNK_ - 1) / RUNOUTS_PER_CHUNK_);
+    std::vector<ShowdownCounts> parts(nslots, ShowdownCounts{0, 0, 0, 0.0e0});
+    std::vector<long long> representatives(nslots, 0);
+    pool_.parallel_for(nchunks, [&](long chunk, int slot) {
+        uint64_t begin = first + uint64_t(chunk) * RUNOUTS_PER_CHUNK_;
+        ShowdownCounts part = enumerate_runouts(query.hole_cards, query.board, remaining, symmetries, nopponents,
+                                                begin, std::min(last, begin + RUNOUTS_PER_CHUNK_), representatives[slot]);
+        parts[slot].wins += part.wins;
+        parts[slot].ties += part.ties;
+        parts[slot].losses += part.losses;
+        parts[slot].tie_share += part.tie_share;
+    });
+    ShowdownCounts counts = {0, 0, 0, 0.0e0};
+    for(int i = 0; i < nslots; ++i) {
+        counts.wins += parts[i].wins;
+        counts.ties += parts[i].ties;
+        counts.losses += parts[i].losses;
+        counts.tie_share += parts[i].tie_share;
+        result.nrunouts += representatives[i];
+    }
+    double total = double(counts.wins + counts.ties + counts.losses);
+    result.method = EquityResult::ENUMERATION;
+    result.counts = counts;
+    result.win = total > 0 ? double(counts.wins) / total : 0.0e0;
+    result.tie = total > 0 ? double(counts.ties) / total : 0.0e0;
+    result.equity = total > 0 ? (double(counts.wins) + counts.tie_share) / total : 0.0e0;
+    result.nsamples = counts.wins + counts.ties + counts.losses;
+    result.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+    return result;
+}
+
+/* number of ways to finish the board, C(cards left, board cards missing) */
+uint64_t EquityEngine::count_runouts(const EquityQuery& query) const {
+    return binomial(static_cast<int>(remaining_cards(query).size()), 5 - static_cast<int>(query.board.size()));
+}
+
+/* the board cards still to come in runout number index.  runouts are the
+   subsets of the cards left (in card index order) in revolving-door order,
+   see RevolvingDoorIterator. */
+std::vector<Card> EquityEngine::runout(const EquityQuery& query, uint64_t index) const {
+    std::vector<Card> remaining = remaining_cards(query);
+    std::vector<Card> cards;
+    int missing = 5 - static_cast<int>(query.board.size());
+    for(uint64_t m = RevolvingDoorIterator::unrank(index, static_cast<int>(remaining.size()), missing); m; m &= m - 1) {
+        cards.push_back(remaining[__builtin_ctzll(m)]);
+    }
+    return cards;
+}
+
+/* number of a runout, the inverse of runout().  a runout of the wrong size,
+   with a card that isn't left or with a card twice has no number and gets
+   count_runouts(query), one past the last */
+uint64_t EquityEngine::runout_index(const EquityQuery& query, const std::vector<Card>& runout) const {
+    std::vector<Card> remaining = remaining_cards(query);
+    int n = static_cast<int>(remaining.size());
+    int missing = 5 - static_cast<int>(query.board.size());
+    uint64_t invalid = binomial(n, missing);
+    if(static_cast<int>(runout.size()) != missing) return invalid;
+    uint64_t positions = 0;
+    for(const Card& c: runout) {
+        std::vector<Card>::const_iterator it = std::find(std::begin(remaining), std::end(remaining), c);
+        if(it == std::end(remaining)) return invalid;
+        uint64_t bit = uint64_t(1) << (it - std::begin(remaining));
+        if(positions & bit) return invalid;
+        positions |= bit;
+    }
+    return RevolvingDoorIterator::rank(positions, n);
+}
+
+/* cards no one holds and that aren't on the board or dead, in card index order */
+std::vector<Card> EquityEngine::remaining_cards(const EquityQuery& query) {
+    CardSet known(query.hole_cards);
+    known.add(CardSet(query.board));
+    known.add(CardSet(query.dead_cards));
+    return CardSet::deck(known.mask()).cards();
+}
+
+/* the suit renamings (4 entries each, identity included) that leave the
+   hole cards, the board and the dead cards each as they are.  runouts they
+   map onto each other score the same.  board and dead cards have to be
+   kept apart: a renaming that swaps a board card for a dead one changes
+   what the hands play with. */
+std::vector<int> EquityEngine::board_symmetries(const EquityQuery& query) {
+    uint64_t hole = SuitIsomorphism::card_mask(query.hole_cards);
+    uint64_t board = SuitIsomorphism::card_mask(query.board);
+    uint64_t dead = SuitIsomorphism::card_mask(query.dead_cards);
+    std::vector<int> symmetries;
+    int suit_map[Card::NUM_SUITS] = {0, 1, 2, 3};
+    do {
+        if(SuitIsomorphism::map_suits(hole, suit_map) == hole && SuitIsomorphism::map_suits(board, suit_map) == board
+           && SuitIsomorphism::map_suits(dead, suit_map) == dead) {
+            symmetries.insert(std::end(symmetries), suit_map, suit_map + Card::NUM_SUITS);
+        }
+    } while(std::next_permutation(suit_map, suit_map + Card::NUM_SUITS));
+    return symmetries;
+}
+
+/* runs batches of trials until the 95% confidence interval of seat 0's
+   equity is no wider than +/- target_half_width, or the budget runs out */
+EquityResult EquityEngine::monte_carlo(const EquityQuery& query) const {
+    EquityResult result;
+    result.error = validate(query);
+    if(!result.error.empty()) return result;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    Deck deck;
+    for(const Card& c: query.dead_cards) deck.delete_card(c);
+    Xoshiro256 rng(query.seed);
+    std::vector<std::unique_ptr<TrialEngine>> engines(pool_.size() + 1);
+    long long ntrials = 0;
+    double half_width = 1.0e0;
+    double elapsed = 0.0e0;
+    long nchunks = MIN_CHUNKS_PER_BATCH_;
+    // the engines keep their own tallies; they are only merged here, once per batch
+    TrialAccumulator total;
+    total.clear();
+    do {
+        // batches double up to MAX_CHUNKS_PER_BATCH_ chunks so long runs do not stop to check too often
+        long long batch = std::min<long long>(TRIALS_PER_CHUNK_ * nchunks, query.max_trials - ntrials);
+        if(nchunks < MAX_CHUNKS_PER_BATCH_) nchunks *= 2;
+        if(!run_trials(query, deck, batch, rng, engines, result.nallocations)) {
+            result.error = "the ranges can't be dealt around each other and the known cards";
+            return result;
+        }
+        ntrials += batch;
+        total.clear();
+        for(const std::unique_ptr<TrialEngine>& engine: engines) {
+            if(engine) total.merge(engine->accumulator());
+        }
+        half_width = wilson_half_width(total.seats[0].wins + total.seats[0].tie_share, ntrials);
+        elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+        if(query.progress) query.progress(ntrials, half_width);
+    } while(half_width > query.target_half_width && elapsed < query.max_seconds && ntrials < query.max_trials);
+    set_sampled(result, query, total, ntrials, half_width, elapsed);
+    return result;
+}
+
+/* monte_carlo() for many queries at once.  every round gives each query
+   that hasn't stopped yet its next batch, the same chunks on the same
+   streams monte_carlo() would run, and the chunks of all of them share one
+   pass over the pool, so a lot of small queries keep every thread busy
+   together.  the chunks' tallies are merged in order, so no answer depends
+   on the thread count or on what else was in the call (except through
+   max_seconds, which counts from the start of the whole call). */
+std::vector<EquityResult> EquityEngine::monte_carlo_batch(const std::vector<EquityQuery>& queries) const {
+    struct Run {
+        Deck deck;
+        Xoshiro256 rng;
+        long nchunks;
+        long long ntrials;
+        bool done;
+        TrialAccumulator total;
+    };
+    struct Chunk {
+        int query;
+        long long ntrials;
+        Xoshiro256 rng;
+    };
+    auto t0 = std::chrono::high_resolution_clock::now();
+    int nqueries = static_cast<int>(queries.size());
+    std::vector<EquityResult> results(nqueries);
+    std::vector<Run> runs(nqueries);
+    for(int i = 0; i < nqueries; ++i) {
+        results[i].error = validate(queries[i]);
+        runs[i].done = !results[i].error.empty();
+        if(runs[i].done) continue;
+        for(const Card& c: queries[i].dead_cards) runs[i].deck.delete_card(c);
+        runs[i].rng = Xoshiro256(queries[i].seed);
+        runs[i].nchunks = MIN_CHUNKS_PER_BATCH_;
+        runs[i].ntrials = 0;
+        runs[i].total.clear();
+    }
+    // an engine is kept per slot and only rebuilt when the slot moves on to another query
+    std::vector<std::unique_ptr<TrialEngine>> engines(pool_.size() + 1);
+    std::vector<int> engine_queries(pool_.size() + 1, -1);
+    std::vector<Chunk> chunks;
+    std::vector<TrialAccumulator> tallies;
+    std::vector<long long> allocations;
+    std::vector<char> dealt;
+    while(true) {
+        chunks.clear();
+        for(int i = 0; i < nqueries; ++i) {
+            Run& run = runs[i];
+            if(run.done) continue;
+            long long batch = std::min<long long>(TRIALS_PER_CHUNK_ * run.nchunks, queries[i].max_trials - run.ntrials);
+            if(run.nchunks < MAX_CHUNKS_PER_BATCH_) run.nchunks *= 2;
+            for(long long first = 0; first < batch; first += TRIALS_PER_CHUNK_) {
+                chunks.push_back(Chunk{i, std::min<long long>(TRIALS_PER_CHUNK_, batch - first), run.rng});
+                run.rng.jump();
+            }
+        }
+        if(chunks.empty()) break;
+        tallies.resize(chunks.size());
+        allocations.assign(chunks.size(), 0);
+        dealt.assign(chunks.size(), 1);
+        pool_.parallel_for(static_cast<long>(chunks.size()), [&](long k, int slot) {
+            const Chunk& chunk = chunks[k];
+            const EquityQuery& query = queries[chunk.query];
+            if(engine_queries[slot] != chunk.query) {
+                engines[slot].reset(new TrialEngine(runs[chunk.query].deck, query.hole_cards, query.board, query.nplayers,
+                                                    query.seed, 0, query.ranges));
+                engine_queries[slot] = chunk.query;
+            }
+            TrialEngine& engine = *engines[slot];
+            long long before = engine.trial_allocations();
+            engine.clear_tallies();
+            engine.set_rng(chunk.rng);
+            engine.run(chunk.ntrials);
+            tallies[k] = engine.accumulator();
+            allocations[k] = engine.trial_allocations() - before;
+            dealt[k] = engine.dealable();
+        });
+        for(size_t k = 0; k < chunks.size(); ++k) {
+            Run& run = runs[chunks[k].query];
+            run.total.merge(tallies[k]);
+            run.ntrials += chunks[k].ntrials;
+            results[chunks[k].query].nallocations += allocations[k];
+            if(!dealt[k]) results[chunks[k].query].error = "the ranges can't be dealt around each other and the known cards";
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - t0).count();
+        for(int i = 0; i < nqueries; ++i) {
+            Run& run = runs[i];
+            const EquityQuery& query = queries[i];
+            if(run.done) continue;
+            if(!results[i].error.empty()) {
+                run.done = true;
+                continue;
+            }
+            double half_width = wilson_half_width(run.total.seats[0].wins + run.total.seats[0].tie_share, run.ntrials);
+            if(query.progress) query.progress(run.ntrials, half_width);
+            if(half_width > query.target_half_width && elapsed < query.max_seconds && run.ntrials < query.max_trials)
+                continue;
+            run.done = true;
+            set_sampled(results[i], query, run.total, run.ntrials, half_width, elapsed);
+        }
+    }
+    return results;
+}
+
+/* a Monte Carlo answer from the run's merged tallies */
+void EquityEngine::set_sampled(EquityResult& result, const EquityQuery& query, const TrialAccumulator& total,
+                               long long ntrials, double half_width, double elapsed) {
+    result.method = EquityResult::MONTE_CARLO;
+    result.win = double(total.seats[0].wins) / double(ntrials);
+    result.tie = double(total.seats[0].ties) / double(ntrials);
+    result.equity = total.seats[0].equity(ntrials);
+    result.variance = total.seats[0].variance(ntrials);
+    result.half_width = half_width;
+    result.nsamples = ntrials;
+    result.seconds = elapsed;
+    result.seats.assign(total.seats, total.seats + query.nplayers);
+}
+
+/* half width of the 95% Wilson score interval, which stays sensible when the
+   probability is close to 0 or 1.  with split pots counted as fractional
+   wins this is an upper bound, since no [0, 1] outcome with the same mean
+   varies more than a win or a loss. */
+double EquityEngine::wilson_half_width(double nwin, long long ntrials) {
+    const double z = 1.96e0;
+    double n = double(ntrials);
+    double p = nwin / n;
+    return z * std::sqrt(p * (1.0e0 - p) / n + z * z / (4.0e0 * n * n)) / (1.0e0 + z * z / n);
+}
+
+/* runs ntrials more trials of the run that rng belongs to on the pool.
+   every chunk takes the next jump-ahead stream of rng, so the result does
+   not depend on which thread ran which chunk.  false if the ranges could
+   not be dealt. */
+bool EquityEngine::run_trials(const EquityQuery& query, const Deck& deck, long long ntrials, Xoshiro256& rng,
+                              std::vector<std::unique_ptr<TrialEngine>>& engines, long long& nallocations) const {
+    long nchunks = static_cast<long>((ntrials + TRIALS_PER_CHUNK_ - 1) / TRIALS_PER_CHUNK_);
+    std::vector<Xoshiro256> streams;
+    for(long i = 0; i < nchunks; ++i) {
+        streams.push_back(rng);
+        rng.jump();
+    }
+    // every engine counts its own allocations, the difference is taken after the chunks are done
+    for(const std::unique_ptr<TrialEngine>& engine: engines) {
+        if(engine) nallocations -= engine->trial_allocations();
+    }
+    pool_.parallel_for(nchunks, [&](long chunk, int slot) {
+        if(!engines[slot]) {
+            engines[slot].reset(new TrialEngine(deck, query.hole_cards, query.board, query.nplayers, query.seed, 0,
+                                                query.ranges));
+        }
+        engines[slot]->set_rng(streams[chunk]);
+        engines[slot]->run(std::min<long long>(TRIALS_PER_CHUNK_, ntrials - chunk * TRIALS_PER_CHUNK_));
+    });
+    bool dealable = true;
+    for(const std::unique_ptr<TrialEngine>& engine: engines) {
+        if(!engine) continue;
+        nallocations += engine->trial_allocations();
+        if(!engine->dealable()) dealable = false;
+    }
+    return dealable;
+}
+
+/* number of (board, unordered set of opponent hands) pairs left to enumerate */
+double EquityEngine::count_showdowns(int nremaining, int nboard_cards_left, int nopponents) {
+    double nboards = 1.0e0;
+    for(int i = 0; i < nboard_cards_left; ++i) nboards = nboards * (nremaining - i) / (i + 1);
+    int ncards = nremaining - nboard_cards_left;
+    double nhands = 1.0e0;
+    for(int i = 0; i < nopponents; ++i) {
+        nhands *= double(ncards - 2 * i) * (ncards - 2 * i - 1) / 2.0e0 / (i + 1);
+    }
+    return nboards * nhands;
+}
+
+/* runouts first to last - 1.  a runout that a symmetry maps onto a lower
+   card mask is skipped, the lowest one of each class counts for all of them. */
+ShowdownCounts EquityEngine::enumerate_runouts(const std::vector<Card>& hole_cards, const std::vector<Card>& community_cards,
+                                               const std::vector<Card>& remaining, const std::vector<int>& symmetries,
+                                               int nopponents, uint64_t first, uint64_t last, long long& nrepresentatives) {
+    ShowdownCounts counts = {0, 0, 0, 0.0e0};
+    long ncommunity = community_cards.size();
+    HandEvaluator::State known = HandEvaluator::state(community_cards.data(), static_cast<int>(ncommunity));
+    std::vector<Card> left;
+    std::vector<Card> pair_cards;
+    std::vector<int> pair_strengths;
+    std::vector<uint64_t> pair_masks;
+    int nsymmetries = static_cast<int>(symmetries.size()) / Card::NUM_SUITS;
+    uint64_t images[24];
+    // runouts come in revolving-door order, so the board state only swaps one card per step
+    RevolvingDoorIterator it(static_cast<int>(remaining.size()), 5 - static_cast<int>(ncommunity), first);
+    HandEvaluator::State board = known;
+    for(uint64_t m = it.mask(); m; m &= m - 1) board = HandEvaluator::add(board, remaining[__builtin_ctzll(m)]);
+    for(uint64_t index = first; index < last; ++index) {
+        if(index != first) {
+            it.next();
+            board = HandEvaluator::add(HandEvaluator::remove(board, remaining[it.removed()]), remaining[it.added()]);
+        }
+        uint64_t runout = 0;
+        for(uint64_t m = it.mask(); m; m &= m - 1) runout |= uint64_t(1) << remaining[__builtin_ctzll(m)].get_index();
+        int nimages = 0;
+        bool lowest = true;
+        for(int s = 0; s < nsymmetries && lowest; ++s) {
+            uint64_t image = SuitIsomorphism::map_suits(runout, &symmetries[s * Card::NUM_SUITS]);
+            if(image < runout) lowest = false;
+            if(std::find(images, images + nimages, image) == images + nimages) images[nimages++] = image;
+        }
+        if(!lowest) continue;
+        long weight = nimages;
+        ++nrepresentatives;
+        // every hand only adds its two cards to the board
+        int hero = HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board, hole_cards[0]), hole_cards[1]));
+        left.clear();
+        for(const Card& c: remaining) {
+            if(!(runout & (uint64_t(1) << c.get_index()))) left.push_back(c);
+        }
+        // every opponent hand is scored once per board, in one batch, and the assignments below only look them up
+        pair_cards.clear();
+        pair_masks.clear();
+        for(size_t i = 0; i < left.size(); ++i) {
+            for(size_t j = i + 1; j < left.size(); ++j) {
+                pair_cards.push_back(left[i]);
+                pair_cards.push_back(left[j]);
+                pair_masks.push_back((uint64_t(1) << left[i].get_index()) | (uint64_t(1) << left[j].get_index()));
+            }
+        }
+        pair_strengths.resize(pair_masks.size());
+        BatchEvaluator::evaluate(board, pair_cards.data(), 2, static_cast<int>(pair_masks.size()), pair_strengths.data());
+        ShowdownCounts runout_counts = {0, 0, 0, 0.0e0};
+        tally_opponents(pair_strengths, pair_masks, 0, 0, nopponents, 0, 0, hero, runout_counts);
+        counts.wins += weight * runout_counts.wins;
+        counts.ties += weight * runout_counts.ties;
+        counts.losses += weight * runout_counts.losses;
+        counts.tie_share += weight * runout_counts.tie_share;
+    }
+    return counts;
+}
+
+/* visits every unordered set of disjoint opponent hands once, in increasing pair order */
+void EquityEngine::tally_opponents(const std::vector<int>& pair_strengths, const std::vector<uint64_t>& pair_masks,
+                                   int first_pair, uint64_t used, int nopponents_left, int best_opponent, int nbest,
+                                   int hero, ShowdownCounts& counts) {
+    if(nopponents_left == 0) {
+        if(best_opponent > hero) {
+            ++counts.losses;
+        } else if(best_opponent == hero) {
+            ++counts.ties;
+            counts.tie_share += 1.0e0 / (nbest + 1);
+        } else {
+            ++counts.wins;
+        }
+        return;
+    }
+    int npairs = static_cast<int>(pair_strengths.size());
+    for(int p = first_pair; p < npairs; ++p) {
+        if(pair_masks[p] & used) continue;
+        int strength = pair_strengths[p];
+        int best = std::max(best_opponent, strength);
+        int count = strength > best_opponent ? 1 : (strength == best_opponent ? nbest + 1 : nbest);
+        tally_opponents(pair_strengths, pair_masks, p + 1, used | pair_masks[p], nopponents_left - 1,
+                        best, count, hero, counts);
+    }
+}
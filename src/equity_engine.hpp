@@ -0,0 +1,118 @@
+//
+//  equity_engine.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef equity_engine_hpp
+#define equity_engine_hpp
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+#include "card.hpp"
+#include "hand_range.hpp"
+#include "trial_engine.hpp"
+#include "thread_pool.hpp"
+#include "preflop_table.hpp"
+#include "rng.hpp"
+
+/* exact showdown tallies from the first player's point of view.  tie_share
+   adds up the first player's fraction of every split pot. */
+struct ShowdownCounts {
+    long long wins;
+    long long ties;
+    long long losses;
+    double tie_share;
+};
+
+/* one equity question.  seat 0 holds hole_cards, the other seats are dealt
+   from their entry in ranges (if any) or at random, and dead_cards are out
+   of play.  Monte Carlo stops after max_trials, after max_seconds, or once
+   the 95% interval of seat 0's equity is within +/- target_half_width
+   (0 runs the whole budget).  progress, if set, is called after every batch. */
+struct EquityQuery {
+    std::vector<Card> hole_cards;
+    std::vector<Card> board;
+    std::vector<Card> dead_cards;
+    std::vector<HandRange> ranges;
+    int nplayers;
+    long long max_trials;
+    double max_seconds;
+    double target_half_width;
+    long long max_showdowns;
+    uint64_t seed;
+    std::function<void(long long ntrials, double half_width)> progress;
+    EquityQuery();
+};
+
+/* the answer to an EquityQuery.  win, tie and equity are seat 0's fractions
+   of the pot; seats has every seat's tally when the answer was sampled and
+   counts the raw showdowns when it was enumerated.  variance is the sample
+   variance of seat 0's pot share per trial, sampled answers only.
+   method is NONE and error says why when nothing could be computed. */
+struct EquityResult {
+    enum Method { NONE, PREFLOP_TABLE, ENUMERATION, MONTE_CARLO };
+    Method method;
+    std::string error;
+    double win;
+    double tie;
+    double equity;
+    double variance;
+    double half_width;
+    long long nsamples;
+    long long nrunouts;
+    long long nallocations;
+    double seconds;
+    std::vector<SeatTally> seats;
+    ShowdownCounts counts;
+    EquityResult();
+};
+
+/* the calculator without any console i/o.  it keeps no state between
+   queries: work runs on the pool it is given and preflop questions are
+   looked up in the table it is given, if any, so one engine can serve
+   queries from any number of threads. */
+class EquityEngine
+{
+public:
+    explicit EquityEngine(ThreadPool& pool, const PreflopTable* preflop_table = nullptr);
+    EquityResult calculate(const EquityQuery& query) const;
+    EquityResult lookup_preflop(const EquityQuery& query) const;
+    EquityResult enumerate(const EquityQuery& query) const;
+    EquityResult enumerate_range(const EquityQuery& query, uint64_t first, uint64_t last) const;
+    uint64_t count_runouts(const EquityQuery& query) const;
+    std::vector<Card> runout(const EquityQuery& query, uint64_t index) const;
+    uint64_t runout_index(const EquityQuery& query, const std::vector<Card>& runout) const;
+    EquityResult monte_carlo(const EquityQuery& query) const;
+    std::vector<EquityResult> monte_carlo_batch(const std::vector<EquityQuery>& queries) const;
+    std::string validate(const EquityQuery& query) const;
+    static double count_showdowns(int nremaining, int nboard_cards_left, int nopponents);
+    static double wilson_half_width(double nwin, long long ntrials);
+private:
+    static const long TRIALS_PER_CHUNK_ = 1024;
+    static const long RUNOUTS_PER_CHUNK_ = 16;
+    static const long MIN_CHUNKS_PER_BATCH_ = 8;
+    static const long MAX_CHUNKS_PER_BATCH_ = 256;
+    ThreadPool& pool_;
+    const PreflopTable* preflop_table_;
+    bool has_ranges(const EquityQuery& query) const;
+    static std::vector<Card> remaining_cards(const EquityQuery& query);
+    static std::vector<int> board_symmetries(const EquityQuery& query);
+    bool run_trials(const EquityQuery& query, const Deck& deck, long long ntrials, Xoshiro256& rng,
+                    std::vector<std::unique_ptr<TrialEngine>>& engines, long long& nallocations) const;
+    static void set_sampled(EquityResult& result, const EquityQuery& query, const TrialAccumulator& total,
+                            long long ntrials, double half_width, double elapsed);
+    static ShowdownCounts enumerate_runouts(const std::vector<Card>& hole_cards, const std::vector<Card>& community_cards,
+                                            const std::vector<Card>& remaining, const std::vector<int>& symmetries,
+                                            int nopponents, uint64_t first, uint64_t last, long long& nrepresentatives);
+    static void tally_opponents(const std::vector<int>& pair_strengths, const std::vector<uint64_t>& pair_masks,
+                                int first_pair, uint64_t used, int nopponents_left, int best_opponent, int nbest,
+                                int hero, ShowdownCounts& counts);
+};
+
+#endif /* equity_engine_hpp */
@@ -0,0 +1,82 @@
+//
+//  hand.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef hand_hpp
+#define hand_hpp
+
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include "card.hpp"
+#include "hand_evaluator.hpp"
+
+/* a hand by value: up to 7 cards stored inline and their strength once
+   scored (0 before).  no heap, no rng and trivially copyable, so hands can
+   be copied and compared on the hot path as freely as ints.  PokerHand
+   wraps one for display. */
+struct Hand {
+    static const int MAX_CARDS = 7;
+    Card cards[MAX_CARDS];
+    uint8_t ncards;
+    int16_t strength;
+
+    static Hand make(const Card* cards, int ncards);
+    static Hand make(const std::vector<Card>& cards);
+    bool add(const Card& c);
+    bool contains(const Card& c) const;
+    int score();
+    int category() const;
+    bool operator<(const Hand& rhs) const { return strength < rhs.strength; }
+    bool operator>(const Hand& rhs) const { return strength > rhs.strength; }
+    bool operator==(const Hand& rhs) const { return strength == rhs.strength; }
+    bool operator!=(const Hand& rhs) const { return strength != rhs.strength; }
+};
+
+static_assert(std::is_trivially_copyable<Hand>::value, "Hand must stay trivially copyable");
+static_assert(std::is_standard_layout<Hand>::value, "Hand must stay a plain struct");
+static_assert(sizeof(Hand) <= 10, "Hand must stay ten bytes");
+
+/* at most MAX_CARDS of cards are kept */
+inline Hand Hand::make(const Card* cards, int ncards) {
+    Hand hand;
+    hand.ncards = 0;
+    hand.strength = 0;
+    for(int i = 0; i < ncards && i < MAX_CARDS; ++i) hand.cards[hand.ncards++] = cards[i];
+    return hand;
+}
+
+inline Hand Hand::make(const std::vector<Card>& cards) {
+    return make(cards.data(), static_cast<int>(cards.size()));
+}
+
+/* false if the hand is full or already holds c */
+inline bool Hand::add(const Card& c) {
+    if(ncards == MAX_CARDS || contains(c)) return false;
+    cards[ncards++] = c;
+    strength = 0;
+    return true;
+}
+
+inline bool Hand::contains(const Card& c) const {
+    for(int i = 0; i < ncards; ++i) {
+        if(cards[i] == c) return true;
+    }
+    return false;
+}
+
+/* strength of the best 5 cards, 0 unless the hand has 5 to 7 cards */
+inline int Hand::score() {
+    strength = static_cast<int16_t>(HandEvaluator::evaluate(cards, ncards));
+    return strength;
+}
+
+inline int Hand::category() const {
+    return HandEvaluator::category(strength);
+}
+
+#endif /* hand_hpp */
@@ -0,0 +1,192 @@
+//
+//  hand_evaluator.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <algorithm>
+#include <vector>
+
+#include "hand_evaluator.hpp"
+
+namespace {
+
+/* sums of up to 7 of these keys (at most 4 of each) are unique per multiset of ranks */
+const uint32_t RANK_KEYS[Card::NUM_RANKS] = {0, 1, 5, 22, 98, 453, 2031, 8698, 22854, 83661, 262349, 636345, 1479181};
+
+enum { HIGH, PAIR, TWO_PAIR, THREE_KIND, STRAIGHT, FLUSH, FULL_HOUSE, FOUR_KIND, STRAIGHT_FLUSH, ROYAL_FLUSH };
+
+/* comparable value of a 5 card hand: category on top, then ranks in order of significance */
+uint32_t raw_value(int category, const int* ranks, int nranks) {
+    uint32_t value = category;
+    for(int i = 0; i < 5; ++i) {
+        value = (value << 4) | (i < nranks ? ranks[i] + 1 : 0);
+    }
+    return value;
+}
+
+/* highest n ranks set in mask, best first */
+int top_ranks(unsigned mask, int n, int* out) {
+    int found = 0;
+    for(int r = Card::NUM_RANKS - 1; r >= 0 && found < n; --r) {
+        if(mask & (1u << r)) out[found++] = r;
+    }
+    return found;
+}
+
+/* rank of the top card of the best straight in mask, -1 if there is none */
+int straight_high(unsigned mask) {
+    for(int high = Card::NUM_RANKS - 1; high >= 4; --high) {
+        unsigned run = 0x1fu << (high - 4);
+        if((mask & run) == run) return high;
+    }
+    unsigned wheel = (1u << 12) | 0xfu;
+    if((mask & wheel) == wheel) return 3;
+    return -1;
+}
+
+uint32_t raw_flush_value(unsigned mask) {
+    int ranks[5];
+    int high = straight_high(mask);
+    if(high == Card::NUM_RANKS - 1) return raw_value(ROYAL_FLUSH, &high, 1);
+    if(high >= 0) return raw_value(STRAIGHT_FLUSH, &high, 1);
+    top_ranks(mask, 5, ranks);
+    return raw_value(FLUSH, ranks, 5);
+}
+
+/* best non flush 5 card hand that can be made from 5 to 7 cards with these rank counts */
+uint32_t raw_rank_value(const int* counts) {
+    unsigned present = 0, pairs = 0, trips = 0;
+    int quad = -1;
+    for(int r = 0; r < Card::NUM_RANKS; ++r) {
+        if(counts[r] >= 1) present |= 1u << r;
+        if(counts[r] >= 2) pairs |= 1u << r;
+        if(counts[r] >= 3) trips |= 1u << r;
+        if(counts[r] >= 4) quad = r;
+    }
+    int ranks[5] = {0};
+    if(quad >= 0) {
+        ranks[0] = quad;
+        top_ranks(present & ~(1u << quad), 1, ranks + 1);
+        return raw_value(FOUR_KIND, ranks, 2);
+    }
+    if(trips) {
+        top_ranks(trips, 1, ranks);
+        if(top_ranks(pairs & ~(1u << ranks[0]), 1, ranks + 1) == 1) return raw_value(FULL_HOUSE, ranks, 2);
+    }
+    int high = straight_high(present);
+    if(high >= 0) return raw_value(STRAIGHT, &high, 1);
+    if(trips) {
+        top_ranks(present & ~(1u << ranks[0]), 2, ranks + 1);
+        return raw_value(THREE_KIND, ranks, 3);
+    }
+    int npairs = top_ranks(pairs, 2, ranks);
+    if(npairs == 2) {
+        top_ranks(present & ~(1u << ranks[0]) & ~(1u << ranks[1]), 1, ranks + 2);
+        return raw_value(TWO_PAIR, ranks, 3);
+    }
+    if(npairs == 1) {
+        top_ranks(present & ~(1u << ranks[0]), 3, ranks + 1);
+        return raw_value(PAIR, ranks, 4);
+    }
+    top_ranks(present, 5, ranks);
+    return raw_value(HIGH, ranks, 5);
+}
+
+/* calls visit(counts, key) for every multiset of ncards ranks with at most 4 of each */
+template <typename F>
+void for_each_rank_multiset(int* counts, int rank, int ncards_left, uint32_t key, F& visit) {
+    if(rank == Card::NUM_RANKS) {
+        if(ncards_left == 0) visit(counts, key);
+        return;
+    }
+    // a local copy, std::min takes references and Card::NUM_SUITS has no out of class definition
+    int nsuits = Card::NUM_SUITS;
+    for(int n = 0; n <= std::min(nsuits, ncards_left); ++n) {
+        counts[rank] = n;
+        for_each_rank_multiset(counts, rank + 1, ncards_left - n, key + n * RANK_KEYS[rank], visit);
+    }
+    counts[rank] = 0;
+}
+
+}
+
+const int HandEvaluator::RANK_TABLE_BITS_[3] = {14, 15, 16};
+
+// a constant initializer, so it is null before any dynamic initializer runs
+std::atomic<const HandEvaluator::Tables*> HandEvaluator::tables_(nullptr);
+
+/* the slow path of tables(): a function-local static, so C++11 builds it
+   once and any other thread that gets here waits for it */
+const HandEvaluator::Tables& HandEvaluator::build_tables() {
+    static const Tables t;
+    tables_.store(&t, std::memory_order_release);
+    return t;
+}
+
+HandEvaluator::Tables::Tables() {
+    for(int c = 0; c < Card::NUM_CARDS; ++c) {
+        Card card = Card::from_index(c);
+        card_keys[c] = RANK_KEYS[card.get_rank()] | (uint64_t(1) << (32 + 4 * card.get_suit()));
+        card_masks[c] = uint64_t(1) << (16 * card.get_suit() + card.get_rank());
+    }
+
+    // every distinct 5 card hand, in order, gives the strength scale
+    std::vector<uint32_t> raw_values;
+    int counts[Card::NUM_RANKS] = {0};
+    auto collect = [&raw_values](const int* c, uint32_t) { raw_values.push_back(raw_rank_value(c)); };
+    for_each_rank_multiset(counts, 0, 5, 0, collect);
+    for(unsigned mask = 0; mask < (1u << Card::NUM_RANKS); ++mask) {
+        if(__builtin_popcount(mask) == 5) raw_values.push_back(raw_flush_value(mask));
+    }
+    std::sort(std::begin(raw_values), std::end(raw_values));
+    raw_values.erase(std::unique(std::begin(raw_values), std::end(raw_values)), std::end(raw_values));
+    auto strength = [&raw_values](uint32_t raw) {
+        return int(std::lower_bound(std::begin(raw_values), std::end(raw_values), raw) - std::begin(raw_values)) + 1;
+    };
+    // each category's strengths start at the weakest hand of it
+    int category_floor[NUM_CATEGORIES];
+    for(int cat = 0; cat < NUM_CATEGORIES; ++cat) {
+        category_floor[cat] = strength(uint32_t(cat) << 20);
+    }
+    for(int s = 0, cat = 0; s <= NUM_STRENGTHS; ++s) {
+        while(cat + 1 < NUM_CATEGORIES && s >= category_floor[cat + 1]) ++cat;
+        categories[s] = static_cast<uint8_t>(cat);
+    }
+
+    for(unsigned mask = 0; mask < (1u << Card::NUM_RANKS); ++mask) {
+        flush[mask] = __builtin_popcount(mask) >= 5 ? strength(raw_flush_value(mask)) : 0;
+    }
+    flush[1 << Card::NUM_RANKS] = 0;
+
+    for(int ncards = 5; ncards <= 7; ++ncards) {
+        int bits = RANK_TABLE_BITS_[ncards - 5];
+        RankEntry* table = new RankEntry[1u << bits];
+        for(uint32_t slot = 0; slot < (1u << bits); ++slot) {
+            table[slot].key = EMPTY_KEY_;
+            table[slot].strength = 0;
+        }
+        // robin hood insertion: an entry further from its home slot takes the place of a
+        // nearer one.  lookups don't change, but the longest probe drops from ~80 slots to
+        // ~10, which is what a batch of lanes probing together waits for (BatchEvaluator)
+        std::vector<int> distances(1u << bits, 0);
+        auto insert = [&](const int* c, uint32_t key) {
+            RankEntry entry = {key, static_cast<uint32_t>(strength(raw_rank_value(c)))};
+            uint32_t slot = (key * 2654435761u) >> (32 - bits);
+            int distance = 0;
+            while(table[slot].key != EMPTY_KEY_) {
+                if(distances[slot] < distance) {
+                    std::swap(table[slot], entry);
+                    std::swap(distances[slot], distance);
+                }
+                slot = (slot + 1) & ((1u << bits) - 1);
+                ++distance;
+            }
+            table[slot] = entry;
+            distances[slot] = distance;
+        };
+        for_each_rank_multiset(counts, 0, ncards, 0, insert);
+        rank_tables[ncards - 5] = table;
+    }
+}
@@ -0,0 +1,153 @@
+//
+//  hand_evaluator.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef hand_evaluator_hpp
+#define hand_evaluator_hpp
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+
+#include "card.hpp"
+
+/* table driven evaluator for 5, 6 or 7 card hands.  every card adds a rank
+   key and a suit counter into one 64 bit word and sets its bit in a 64 bit
+   mask (16 bits per suit).  a flush is looked up by the rank mask of the
+   flush suit, anything else by the sum of rank keys, which is unique per
+   multiset of ranks.  no subsets are enumerated.
+
+   strengths run from 1 (7-5-4-3-2 high) to NUM_STRENGTHS (royal flush), one
+   value per distinct 5 card hand, so hands compare with a single int compare.
+
+   the key and mask of a partial hand are a State, so cards everyone shares
+   (the board) can be added once and each player's hole cards folded in
+   after: evaluate(add(add(board, h1), h2)).  remove() takes a card back out,
+   so a walk that changes one card at a time never rebuilds a state. */
+class HandEvaluator
+{
+public:
+    static const int NUM_STRENGTHS = 7462;
+    static const int NUM_CATEGORIES = 10;
+    struct State {
+        uint64_t key;
+        uint64_t mask;
+        int ncards;
+    };
+    static State state(const Card* cards, int ncards);
+    static State add(const State& state, const Card& c);
+    static State remove(const State& state, const Card& c);
+    static int evaluate(const State& state);
+    static int evaluate(const Card* cards, int ncards);
+    static int evaluate(const std::vector<Card>& cards);
+    static int category(int strength);
+    static void prefetch(const State& state);
+private:
+    friend class BatchEvaluator;
+    struct RankEntry {
+        uint32_t key;
+        uint32_t strength;
+    };
+    /* everything the evaluator looks up.  flush has one spare entry, so a
+       4 byte gather of the last one (BatchEvaluator) stays inside */
+    struct Tables {
+        uint64_t card_keys[Card::NUM_CARDS];
+        uint64_t card_masks[Card::NUM_CARDS];
+        uint16_t flush[(1 << Card::NUM_RANKS) + 1];
+        RankEntry* rank_tables[3];
+        uint8_t categories[NUM_STRENGTHS + 1];
+        Tables();
+    };
+    static const uint32_t EMPTY_KEY_ = 0xffffffffu;
+    static const int RANK_TABLE_BITS_[3];
+    static std::atomic<const Tables*> tables_;
+    static const Tables& tables();
+    static const Tables& build_tables();
+    static int lookup(uint64_t key, uint64_t mask, int ncards);
+};
+
+/* built on first use by whoever gets here first (main(), a pool worker or
+   another static's initializer), so nothing reads them before they're
+   filled in.  after that it's one load */
+inline const HandEvaluator::Tables& HandEvaluator::tables() {
+    const Tables* t = tables_.load(std::memory_order_acquire);
+    return __builtin_expect(t != nullptr, 1) ? *t : build_tables();
+}
+
+inline int HandEvaluator::lookup(uint64_t key, uint64_t mask, int ncards) {
+    const Tables& t = tables();
+    // suit counters start at 3 so a count of 5 or more sets the top bit of its nibble
+    unsigned flush = (static_cast<unsigned>(key >> 32) + 0x3333u) & 0x8888u;
+    if(flush) {
+        int suit = __builtin_ctz(flush) >> 2;
+        return t.flush[(mask >> (16 * suit)) & 0x1fff];
+    }
+    uint32_t rank_key = static_cast<uint32_t>(key);
+    int bits = RANK_TABLE_BITS_[ncards - 5];
+    const RankEntry* table = t.rank_tables[ncards - 5];
+    uint32_t slot = (rank_key * 2654435761u) >> (32 - bits);
+    while(table[slot].key != rank_key) {
+        if(table[slot].key == EMPTY_KEY_) return 0;
+        slot = (slot + 1) & ((1u << bits) - 1);
+    }
+    return table[slot].strength;
+}
+
+inline HandEvaluator::State HandEvaluator::state(const Card* cards, int ncards) {
+    const Tables& t = tables();
+    State s = {0, 0, ncards};
+    for(int i = 0; i < ncards; ++i) {
+        s.key += t.card_keys[cards[i].get_index()];
+        s.mask |= t.card_masks[cards[i].get_index()];
+    }
+    return s;
+}
+
+inline HandEvaluator::State HandEvaluator::add(const State& state, const Card& c) {
+    const Tables& t = tables();
+    State s = {state.key + t.card_keys[c.get_index()], state.mask | t.card_masks[c.get_index()], state.ncards + 1};
+    return s;
+}
+
+/* c must be in the state */
+inline HandEvaluator::State HandEvaluator::remove(const State& state, const Card& c) {
+    const Tables& t = tables();
+    State s = {state.key - t.card_keys[c.get_index()], state.mask & ~t.card_masks[c.get_index()], state.ncards - 1};
+    return s;
+}
+
+/* strength of a state of 5 to 7 cards, 0 for any other number */
+inline int HandEvaluator::evaluate(const State& state) {
+    if(state.ncards < 5 || state.ncards > 7) return 0;
+    return lookup(state.key, state.mask, state.ncards);
+}
+
+/* starts loading the rank table entry a later evaluate(state) will probe
+   first, so a caller that builds many states before scoring them doesn't
+   wait on each miss.  flushes and other sizes are left alone */
+inline void HandEvaluator::prefetch(const State& state) {
+    if(state.ncards < 5 || state.ncards > 7) return;
+    if((static_cast<unsigned>(state.key >> 32) + 0x3333u) & 0x8888u) return;
+    int bits = RANK_TABLE_BITS_[state.ncards - 5];
+    uint32_t slot = (static_cast<uint32_t>(state.key) * 2654435761u) >> (32 - bits);
+    __builtin_prefetch(&tables().rank_tables[state.ncards - 5][slot]);
+}
+
+/* strength from 0 to NUM_STRENGTHS, one table read so tallies can count
+   categories per trial */
+inline int HandEvaluator::category(int strength) {
+    return tables().categories[strength];
+}
+
+inline int HandEvaluator::evaluate(const Card* cards, int ncards) {
+    return evaluate(state(cards, ncards));
+}
+
+inline int HandEvaluator::evaluate(const std::vector<Card>& cards) {
+    return evaluate(cards.data(), static_cast<int>(cards.size()));
+}
+
+#endif /* hand_evaluator_hpp */
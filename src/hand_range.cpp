@@ -0,0 +1,242 @@
+//
+//  hand_range.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+#include "hand_range.hpp"
+
+namespace {
+
+enum { ANY_SUITS, SUITED, OFFSUIT };
+
+const char RANK_CHARS[] = "23456789TJQKA";
+const char SUIT_CHARS[] = "schd";
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if(begin == std::string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+}
+
+HandRange::HandRange() {
+    for(int i = 0; i < NUM_COMBOS; ++i) weights_[i] = 0;
+}
+
+int HandRange::combo_index(const Card& a, const Card& b) {
+    int lo = std::min(a.get_index(), b.get_index());
+    int hi = std::max(a.get_index(), b.get_index());
+    return hi * (hi - 1) / 2 + lo;
+}
+
+int HandRange::parse_rank(char c) {
+    for(int r = 0; r < Card::NUM_RANKS; ++r) {
+        if(std::toupper(c) == RANK_CHARS[r]) return r;
+    }
+    return -1;
+}
+
+int HandRange::parse_suit(char c) {
+    for(int s = 0; s < Card::NUM_SUITS; ++s) {
+        if(std::tolower(c) == SUIT_CHARS[s]) return s;
+    }
+    return -1;
+}
+
+bool HandRange::parse(const std::string& text) {
+    for(int i = 0; i < NUM_COMBOS; ++i) weights_[i] = 0;
+    text_ = trim(text);
+    error_.clear();
+    std::stringstream ss(text_);
+    std::string token;
+    while(std::getline(ss, token, ',')) {
+        token = trim(token);
+        if(token.empty()) continue;
+        if(!parse_token(token)) {
+            if(error_.empty()) error_ = "can't parse \"" + token + "\"";
+            for(int i = 0; i < NUM_COMBOS; ++i) weights_[i] = 0;
+            build_sampler();
+            return false;
+        }
+    }
+    build_sampler();
+    if(combos_.empty()) {
+        error_ = "range \"" + text_ + "\" has no hands in it";
+        return false;
+    }
+    return true;
+}
+
+/* one comma separated token: a hand class with an optional +, - or :weight */
+bool HandRange::parse_token(const std::string& token) {
+    std::string hand = token;
+    double weight = 1;
+    size_t colon = token.find(':');
+    if(colon != std::string::npos) {
+        hand = trim(token.substr(0, colon));
+        std::string w = trim(token.substr(colon + 1));
+        char* end = nullptr;
+        weight = std::strtod(w.c_str(), &end);
+        if(w.empty() || *end != '\0' || weight < 0) {
+            error_ = "bad weight in \"" + token + "\"";
+            return false;
+        }
+    }
+
+    // a single combo, e.g. AhKh
+    if(hand.size() == 4 && parse_suit(hand[1]) >= 0 && parse_suit(hand[3]) >= 0) {
+        int r1 = parse_rank(hand[0]), r2 = parse_rank(hand[2]);
+        Card a(parse_suit(hand[1]), r1), b(parse_suit(hand[3]), r2);
+        if(r1 < 0 || r2 < 0 || a == b) return false;
+        weights_[combo_index(a, b)] = weight;
+        return true;
+    }
+
+    // hand class, e.g. AK, AKs, AKo, with an optional + or -second class
+    auto read_class = [](const std::string& s, size_t& pos, int& high, int& low, int& suitedness) {
+        if(pos + 2 > s.size()) return false;
+        high = parse_rank(s[pos]);
+        low = parse_rank(s[pos + 1]);
+        if(high < 0 || low < 0) return false;
+        if(high < low) std::swap(high, low);
+        pos += 2;
+        suitedness = ANY_SUITS;
+        if(pos < s.size() && (s[pos] == 's' || s[pos] == 'S')) { suitedness = SUITED; ++pos; }
+        else if(pos < s.size() && (s[pos] == 'o' || s[pos] == 'O')) { suitedness = OFFSUIT; ++pos; }
+        return high != low || suitedness == ANY_SUITS;
+    };
+    size_t pos = 0;
+    int high, low, suitedness;
+    if(!read_class(hand, pos, high, low, suitedness)) return false;
+
+    if(pos == hand.size()) {
+        add_class(high, low, suitedness, weight);
+        return true;
+    }
+    if(hand[pos] == '+' && pos + 1 == hand.size()) {
+        if(high == low) {
+            for(int r = high; r < Card::NUM_RANKS; ++r) add_class(r, r, suitedness, weight);
+        }
+        else {
+            for(int r = low; r < high; ++r) add_class(high, r, suitedness, weight);
+        }
+        return true;
+    }
+    if(hand[pos] == '-') {
+        ++pos;
+        int high2, low2, suitedness2;
+        if(!read_class(hand, pos, high2, low2, suitedness2) || pos != hand.size()) return false;
+        if(suitedness2 != suitedness) return false;
+        if(high2 > high) { std::swap(high, high2); std::swap(low, low2); }
+        if(high == low && high2 == low2) {
+            for(int r = high2; r <= high; ++r) add_class(r, r, suitedness, weight);
+            return true;
+        }
+        if(high == high2 && high != low && high2 != low2) {
+            for(int r = std::min(low, low2); r <= std::max(low, low2); ++r) add_class(high, r, suitedness, weight);
+            return true;
+        }
+        if(high - low == high2 - low2 && high != low) {
+            for(int d = 0; d <= high - high2; ++d) add_class(high2 + d, low2 + d, suitedness, weight);
+            return true;
+        }
+        error_ = "\"" + token + "\" isn't a pair, kicker or connector run";
+        return false;
+    }
+    return false;
+}
+
+void HandRange::add_class(int high, int low, int suitedness, double weight) {
+    for(int s1 = 0; s1 < Card::NUM_SUITS; ++s1) {
+        for(int s2 = 0; s2 < Card::NUM_SUITS; ++s2) {
+            if(high == low && s2 <= s1) continue;
+            if(suitedness == SUITED && s1 != s2) continue;
+            if(suitedness == OFFSUIT && s1 == s2) continue;
+            weights_[combo_index(Card(s1, high), Card(s2, low))] = weight;
+        }
+    }
+}
+
+const std::string& HandRange::error() const {
+    return error_;
+}
+
+const std::string& HandRange::str() const {
+    return text_;
+}
+
+void HandRange::set_weight(const Card& a, const Card& b, double weight) {
+    if(a == b) return;
+    weights_[combo_index(a, b)] = weight;
+    build_sampler();
+}
+
+void HandRange::remove_dead(uint64_t dead_cards) {
+    for(int hi = 1; hi < Card::NUM_CARDS; ++hi) {
+        for(int lo = 0; lo < hi; ++lo) {
+            uint64_t mask = (uint64_t(1) << hi) | (uint64_t(1) << lo);
+            if(mask & dead_cards) weights_[hi * (hi - 1) / 2 + lo] = 0;
+        }
+    }
+    build_sampler();
+}
+
+bool HandRange::empty() const {
+    return combos_.empty();
+}
+
+int HandRange::size() const {
+    return static_cast<int>(combos_.size());
+}
+
+/* vose's alias method: every slot keeps its own combo with probability
+   thresholds_[i] / 2^32 and hands the rest to aliases_[i] */
+void HandRange::build_sampler() {
+    combos_.clear();
+    std::vector<double> weights;
+    double total = 0;
+    for(int hi = 1; hi < Card::NUM_CARDS; ++hi) {
+        for(int lo = 0; lo < hi; ++lo) {
+            double w = weights_[hi * (hi - 1) / 2 + lo];
+            if(w <= 0) continue;
+            Combo c;
+            c.first = Card::from_index(hi);
+            c.second = Card::from_index(lo);
+            c.mask = (uint64_t(1) << hi) | (uint64_t(1) << lo);
+            combos_.push_back(c);
+            weights.push_back(w);
+            total += w;
+        }
+    }
+    int n = static_cast<int>(combos_.size());
+    thresholds_.assign(n, uint64_t(1) << 32);
+    aliases_.resize(n);
+    std::vector<int> small, large;
+    std::vector<double> scaled(n);
+    for(int i = 0; i < n; ++i) {
+        aliases_[i] = i;
+        scaled[i] = weights[i] * n / total;
+        (scaled[i] < 1 ? small : large).push_back(i);
+    }
+    while(!small.empty() && !large.empty()) {
+        int s = small.back(), l = large.back();
+        small.pop_back();
+        thresholds_[s] = static_cast<uint64_t>(scaled[s] * 4294967296.0);
+        aliases_[s] = l;
+        scaled[l] -= 1 - scaled[s];
+        if(scaled[l] < 1) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // whatever is left over is 1 up to rounding and keeps its own combo
+}
@@ -0,0 +1,83 @@
+//
+//  hand_range.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef hand_range_hpp
+#define hand_range_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "card.hpp"
+#include "rng.hpp"
+
+/* a weighted set of two card hands, parsed from the usual notation:
+     "QQ+, AKs, AQo:0.5, 76s-54s, A5s-A2s, KTs+, 99-66, AhKh"
+   a token without s or o means both, "+" raises the lower card up to one
+   below the higher one (or all higher pairs), "-" walks a pair or a fixed
+   gap hand down to the second hand, and ":w" gives the token a weight (1
+   by default).  a combo named twice keeps the last weight.
+
+   combos are drawn in O(1) from an alias table over the combos with
+   non-zero weight.  remove_dead() drops the combos that touch known cards
+   before sampling starts. */
+class HandRange
+{
+public:
+    static const int NUM_COMBOS = Card::NUM_CARDS * (Card::NUM_CARDS - 1) / 2;
+    HandRange();
+    bool parse(const std::string& text);
+    const std::string& error() const;
+    const std::string& str() const;
+    void set_weight(const Card& a, const Card& b, double weight);
+    void remove_dead(uint64_t dead_cards);
+    bool empty() const;
+    int size() const;
+    int sample(Xoshiro256& rng) const;
+    Card first(int combo) const;
+    Card second(int combo) const;
+    uint64_t mask(int combo) const;
+    static int combo_index(const Card& a, const Card& b);
+private:
+    struct Combo {
+        Card first;
+        Card second;
+        uint64_t mask;
+    };
+    double weights_[NUM_COMBOS];
+    std::string text_;
+    std::string error_;
+    std::vector<Combo> combos_;
+    std::vector<uint64_t> thresholds_;
+    std::vector<int> aliases_;
+    void build_sampler();
+    bool parse_token(const std::string& token);
+    void add_class(int high, int low, int suitedness, double weight);
+    static int parse_rank(char c);
+    static int parse_suit(char c);
+};
+
+/* picks a live combo with probability proportional to its weight */
+inline int HandRange::sample(Xoshiro256& rng) const {
+    int i = static_cast<int>(rng.bounded(static_cast<uint32_t>(combos_.size())));
+    if((rng.next() >> 32) < thresholds_[i]) return i;
+    return aliases_[i];
+}
+
+inline Card HandRange::first(int combo) const {
+    return combos_[combo].first;
+}
+
+inline Card HandRange::second(int combo) const {
+    return combos_[combo].second;
+}
+
+inline uint64_t HandRange::mask(int combo) const {
+    return combos_[combo].mask;
+}
+
+#endif /* hand_range_hpp */
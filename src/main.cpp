@@ -7,21 +7,82 @@
 //
 
 #include <algorithm>
+#include <string>
+#include <fstream>
+#include <ctime>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
 
 #include "poker_game.hpp"
+#include "batch_runner.hpp"
 
+namespace {
+
+const char* USAGE =
+    "usage: poker [seed]                              interactive, one hand\n"
+    "       poker --batch [--json] [--seed=N] [file]  one scenario per line of file (or stdin)\n";
+
+/* a seed is all decimal digits and fits in 64 bits; strtoull alone would
+   take "-1" or " 7" */
+bool parse_seed(const std::string& text, uint64_t& seed) {
+    if(text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    char* end = nullptr;
+    errno = 0;
+    seed = std::strtoull(text.c_str(), &end, 10);
+    return *end == '\0' && errno != ERANGE;
+}
+
+int usage(const std::string& bad) {
+    std::cerr << "bad seed \"" << bad << "\"" << std::endl << USAGE;
+    return 1;
+}
+
+}
+
+/* poker [seed]                                   interactive, one hand
+   poker --batch [--json] [--seed=N] [file]        one scenario per line of file (or stdin),
+                                                  see BatchRunner */
 int main(int argc, const char * argv[]) {
+    if(argc > 1 && std::string(argv[1]) == "--batch") {
+        BatchRunner::Format format = BatchRunner::CSV;
+        uint64_t seed = time(0);
+        std::string path = "-";
+        for(int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if(arg == "--json") format = BatchRunner::JSON;
+            else if(arg == "--csv") format = BatchRunner::CSV;
+            else if(arg.compare(0, 7, "--seed=") == 0) {
+                if(!parse_seed(arg.substr(7), seed)) return usage(arg.substr(7));
+            }
+            else path = arg;
+        }
+        if(path == "-") {
+            BatchRunner(std::cin, std::cout, format, seed).run();
+            return 0;
+        }
+        std::ifstream in(path.c_str());
+        if(!in) {
+            std::cerr << "can't open " << path << std::endl;
+            return 1;
+        }
+        BatchRunner(in, std::cout, format, seed).run();
+        return 0;
+    }
+    uint64_t seed = 0;
+    if(argc > 1 && !parse_seed(argv[1], seed)) return usage(argv[1]);
     std::string prompt;
     std::cout << " ===================================== " << std::endl;
     std::cout << " === TEXAS HOLD'EM ODDS CALCULATOR === " << std::endl;
     std::cout << " ===================================== " << std::endl;
     do {
         PokerGame game;
+        if(argc > 1) game.set_seed(seed);
         game.init_hand();
         game.init_community();
-        //game.monte_carlo_omp_wrap(20000);
+        game.init_ranges();
         //game.monte_carlo_loop(25000);
-        game.monte_carlo_loop_thread(100000);
+        if(!game.lookup_preflop() && game.enumerate_all() < 0) game.monte_carlo_adaptive();
         return 0;
         std::cout << "Would you like to do another hand (y or n)? ";
         std::cin >> prompt;
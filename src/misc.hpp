@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <vector>
+#include <cstdint>
 
 /* make all combinations in a list of size k and place them into result 2d vector */
 //template <typename T>
@@ -37,5 +38,202 @@ std::vector<std::vector<T>> combinations(const std::vector<T>& full_list, int su
     return result;
 }
 
+/* C(n, k) for n up to 64, 0 when k is out of range */
+inline uint64_t binomial(int n, int k) {
+    static const struct Table {
+        uint64_t c[65][65];
+        Table() {
+            for(int i = 0; i <= 64; ++i) {
+                c[i][0] = 1;
+                for(int j = 1; j <= 64; ++j) c[i][j] = i == 0 ? 0 : c[i - 1][j - 1] + c[i - 1][j];
+            }
+        }
+    } table;
+    if(n < 0 || k < 0 || n > 64 || k > n) return 0;
+    return table.c[n][k];
+}
+
+/* every k-subset of n items (n <= 64) as a bit mask, in increasing order of
+   the mask by Gosper's hack, without allocating anything:
+
+     for(CombinationIterator it(n, k); !it.done(); it.next()) use(it.mask());
+
+   masks come in colexicographic order, the order the combinatorial number
+   system numbers subsets in, so the i-th mask is unrank_combination(i, k). */
+class CombinationIterator
+{
+public:
+    CombinationIterator(int n, int k) : n_(n), done_(k < 0 || k > n) {
+        mask_ = k <= 0 ? 0 : (k >= 64 ? ~uint64_t(0) : (uint64_t(1) << k) - 1);
+    }
+    CombinationIterator(int n, uint64_t first_mask) : n_(n), mask_(first_mask), done_(false) { }
+    bool done() const { return done_; }
+    uint64_t mask() const { return mask_; }
+    void next() {
+        if(mask_ == 0) {
+            done_ = true;
+            return;
+        }
+        uint64_t lowest = mask_ & (~mask_ + 1);
+        uint64_t ripple = mask_ + lowest;
+        if(ripple == 0) {
+            done_ = true;
+            return;
+        }
+        mask_ = (((ripple ^ mask_) >> 2) / lowest) | ripple;
+        if(n_ < 64 && (mask_ >> n_)) done_ = true;
+    }
+private:
+    int n_;
+    uint64_t mask_;
+    bool done_;
+};
+
+/* the k-subset with colexicographic rank index, index < C(n, k) for subsets of n items */
+inline uint64_t unrank_combination(uint64_t index, int k) {
+    uint64_t mask = 0;
+    for(int i = k; i >= 1; --i) {
+        int c = i - 1;
+        while(binomial(c + 1, i) <= index) ++c;
+        index -= binomial(c, i);
+        mask |= uint64_t(1) << c;
+    }
+    return mask;
+}
+
+/* colexicographic rank of the subset in mask among all subsets of its size,
+   the inverse of unrank_combination: sum of C(position, i) over its i-th
+   lowest position, counting i from 1 */
+inline uint64_t rank_combination(uint64_t mask) {
+    uint64_t index = 0;
+    for(int i = 1; mask; ++i, mask &= mask - 1) index += binomial(__builtin_ctzll(mask), i);
+    return index;
+}
+
+/* every k-subset of n items (n <= 64) in revolving-door order (Knuth's
+   algorithm R): each subset differs from the one before by one item going
+   out and one coming in, so anything built from a subset can be updated by
+   that delta instead of rebuilt.  the order is the subsets without item
+   n - 1 in revolving-door order, then those with it in reverse order, and
+   unrank()/rank() number it the same way, so a walk can start anywhere. */
+class RevolvingDoorIterator
+{
+public:
+    RevolvingDoorIterator(int n, int k, uint64_t index = 0) : n_(n), k_(k), removed_(-1), added_(-1) {
+        done_ = k < 0 || k > n || index >= binomial(n, k);
+        mask_ = done_ ? 0 : unrank(index, n, k);
+        uint64_t m = mask_;
+        for(int i = 0; i < k_ && m; ++i, m &= m - 1) c_[i + 1] = __builtin_ctzll(m);
+        c_[k_ + 1 > 0 ? k_ + 1 : 0] = n;
+    }
+    bool done() const { return done_; }
+    uint64_t mask() const { return mask_; }
+    /* the item that left and the one that came in at the last next(), -1 before the first */
+    int removed() const { return removed_; }
+    int added() const { return added_; }
+    void next() {
+        if(!step()) {
+            done_ = true;
+            return;
+        }
+        mask_ ^= (uint64_t(1) << removed_) | (uint64_t(1) << added_);
+    }
+    static uint64_t unrank(uint64_t index, int n, int k) {
+        uint64_t mask = 0;
+        for(int m = n; m > 0 && k > 0; --m) {
+            uint64_t without = binomial(m - 1, k);
+            if(index < without) continue;
+            index = binomial(m - 1, k - 1) - 1 - (index - without);
+            mask |= uint64_t(1) << (m - 1);
+            --k;
+        }
+        return mask;
+    }
+    static uint64_t rank(uint64_t mask, int n) {
+        int k = __builtin_popcountll(mask);
+        int64_t base = 0;
+        int64_t sign = 1;
+        for(int m = n; m > 0 && k > 0; --m) {
+            if(!(mask & (uint64_t(1) << (m - 1)))) continue;
+            base += sign * int64_t(binomial(m - 1, k) + binomial(m - 1, k - 1) - 1);
+            sign = -sign;
+            --k;
+        }
+        return static_cast<uint64_t>(base);
+    }
+private:
+    int n_;
+    int k_;
+    int c_[66];
+    uint64_t mask_;
+    int removed_;
+    int added_;
+    bool done_;
+    /* algorithm R on c_[1..k_] (increasing, c_[k_ + 1] = n), sets removed_
+       and added_, false after the last subset */
+    bool step() {
+        int* c = c_;
+        int t = k_;
+        if(t == 0 || t == n_) return false;
+        if(t == 1) {
+            if(c[1] + 1 >= n_) return false;
+            removed_ = c[1]++;
+            added_ = c[1];
+            return true;
+        }
+        int j;
+        if(t & 1) {
+            if(c[1] + 1 < c[2]) {
+                removed_ = c[1]++;
+                added_ = c[1];
+                return true;
+            }
+            j = 2;
+        } else {
+            if(c[1] > 0) {
+                removed_ = c[1]--;
+                added_ = c[1];
+                return true;
+            }
+            j = 2;
+            goto increase;
+        }
+        for(;;) {
+            // c[j] == c[j - 1] + 1 here
+            if(c[j] >= j) {
+                removed_ = c[j];
+                added_ = j - 2;
+                c[j] = c[j - 1];
+                c[j - 1] = j - 2;
+                return true;
+            }
+            ++j;
+        increase:
+            // c[j - 1] == j - 2 here
+            if(c[j] + 1 < c[j + 1]) {
+                removed_ = j - 2;
+                added_ = c[j] + 1;
+                c[j - 1] = c[j];
+                ++c[j];
+                return true;
+            }
+            ++j;
+            if(j > t) return false;
+        }
+    }
+};
+
+/* calls visit(subset, k) for every k-subset of items (at most 64 of them).
+   subset points at a buffer that is refilled for each call. */
+template <typename T, typename F>
+void for_each_combination(const std::vector<T>& items, int k, F visit) {
+    T subset[64];
+    int n = static_cast<int>(items.size());
+    for(CombinationIterator it(n, k); !it.done(); it.next()) {
+        uint64_t mask = it.mask();
+        for(int i = 0; mask; ++i, mask &= mask - 1) subset[i] = items[__builtin_ctzll(mask)];
+        visit(static_cast<const T*>(subset), k);
+    }
+}
 
 #endif /* misc_hpp */
@@ -9,18 +9,32 @@
 #include <iostream>
 #include <vector>
 #include <iomanip>
+#include <sstream>
 #include <ctime>
 #include <chrono>
 #include <thread>
 #include <future>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <limits>
 
 #include "poker_game.hpp"
 #include "misc.hpp"
 #include "poker_hand.hpp"
 #include "deck.hpp"
+#include "hand_evaluator.hpp"
+#include "trial_engine.hpp"
+#include "alloc_counter.hpp"
+#include "thread_pool.hpp"
+#include "preflop_table.hpp"
+#include "equity_engine.hpp"
+#include "rng.hpp"
 
 PokerGame::PokerGame() {
     deck_ = Deck();
+    seed_ = time(0);
     int num_players;
     do {
         std::cout << "Enter number of players " << std::endl;
@@ -33,10 +47,20 @@ PokerGame::PokerGame() {
     for(int i = 0; i < num_players; ++i) {
         players_.push_back(PokerHand());
     }
+    ranges_.resize(num_players);
 }
 
 PokerGame::~PokerGame() { };
 
+/* every Monte Carlo run is reproducible from this seed and its thread count */
+void PokerGame::set_seed(uint64_t seed) {
+    seed_ = seed;
+}
+
+uint64_t PokerGame::get_seed() const {
+    return seed_;
+}
+
 void PokerGame::init_hand() {
     std::cout << "cards in deck: " << std::endl;
     std::cout << deck_.str() << std::endl;
@@ -74,156 +98,74 @@ void PokerGame::init_community() {
     std::cout << std::endl;
 }
 
-void PokerGame::monte_carlo_loop(const int& ntrials) {
-    std::cout << "Evaluating win probability using Monte Carlo." << std::endl;
-    long community_cards_left = 5 - community_cards_.size();
-    int nwin = 0;
-    auto t0 = std::chrono::high_resolution_clock::now();
-    for(int i = 0; i < ntrials; ++i) {
-        double pct_done = double(i + 1) / double(ntrials) * 100.0e0;
-        std::cout << "  " << i + 1 << " out of " << ntrials
-                  << " trials (" << std::fixed << std::setprecision(2) << pct_done << "%)" << "\r";
-        nwin += monte_carlo_trial(community_cards_left);
+/* asks for a range for every opponent, a blank line leaves the seat random */
+void PokerGame::init_ranges() {
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    for(int seat = 1; seat < static_cast<int>(players_.size()); ++seat) {
+        std::string line;
+        do {
+            std::cout << "range for seat " << seat + 1 << " (e.g. QQ+, AKs, 76s-54s:0.5, blank for random): ";
+            if(!std::getline(std::cin, line)) line.clear();
+        } while(!set_range(seat, line));
     }
     std::cout << std::endl;
-    double pct = double(nwin) / double(ntrials)  * 100.e0;
-    auto tf = std::chrono::high_resolution_clock::now();
-    auto duration = (double)std::chrono::duration_cast<std::chrono::milliseconds>(tf -t0).count();
-    std::cout << std::endl;
-    std::cout << players_[0].str() << "wins approximately " << pct << "% of hands. "
-              << "Calculation took " << duration / 1000 << " seconds. " << std::endl;
-    std::cout << std::endl;
 }
 
-int PokerGame::monte_carlo_omp(Deck deck, std::vector<PokerHand> players, std::vector<Card> community_cards,
-                                         int community_cards_left, int ntrials) {
-    int nwin = 0;
-    //auto t0 = omp_get_wtime();
-#pragma omp parallel for schedule(static) firstprivate(deck, players, community_cards)
-    for(int i = 0; i < ntrials; ++i) {
-        //deck.repopulate();
-        //for (const Card &c: players[0].get_deck()) {
-        //    deck.delete_card(c);
-        //}
-        //for (const Card &c: community_cards) {
-        //    deck.delete_card(c);
-        //}
-        for (int i_player = 1; i_player < players.size(); i_player++) {
-            for (int i_card = 0; i_card < 2; ++i_card) {
-                players[i_player].add_back(deck.draw_delete_rand_card());
-            }
-        }
-        for (int i_card = 0; i_card < community_cards_left; ++i_card)
-            community_cards.push_back(deck.draw_delete_rand_card());
-        std::vector<PokerHand> best_hands;
-        for (PokerHand &player: players) {
-            std::vector<Card> tmp;
-            for (const Card &c: player.get_deck()) {
-                tmp.push_back(c);
-            }
-            for (const Card &c: community_cards) {
-                tmp.push_back(c);
-            }
-            std::vector<std::vector<Card>> five_card_hands = combinations(tmp, 5);
-            PokerHand best_hand = find_best_hand(five_card_hands);
-            best_hands.push_back(best_hand);
-            five_card_hands.clear();
-        }
-        bool user_win = true;
-        for (int i = 1; i < players.size(); ++i) {
-            if (best_hands[0] < best_hands[i]) {
-                user_win = false;
-            }
-        }
-        if(user_win) {
-#pragma omp atomic
-            ++nwin;
-        }
-        //for (int i = 1; i < players.size(); ++i) players[i].clear();
-        for (int i = 1; i < players.size(); ++i) {
-            for(int j = 0; j < 2; ++j) {
-                deck.add_back(players[i].draw_delete_back());
-            }
-        }
-        best_hands.clear();
-        for (int i_card = 0; i_card < community_cards_left; ++i_card) {
-            deck.add_back(community_cards.back());
-            community_cards.pop_back();
-        }
+/* seat is dealt a hand from text from now on, empty text makes it random again */
+bool PokerGame::set_range(int seat, const std::string& text) {
+    if(text.find_first_not_of(" \t\r") == std::string::npos) {
+        ranges_[seat] = HandRange();
+        return true;
     }
-    //auto time = omp_get_wtime() - t0;
-    //return std::pair<int, double> (nwin, 0.0e0);
-    return nwin;
-}
-/*
-void PokerGame::monte_carlo_omp_wrap(const int ntrials) {
-    int community_cards_left = 5 - community_cards_.size();
-    std::pair<int, double> stats = monte_carlo_omp(deck_, players_, community_cards_, community_cards_left, ntrials);
-    std::cout << std::endl;
-    double pct = double(stats.first) / double(ntrials)  * 100.e0;
-    std::cout << std::endl;
-    std::cout << players_[0].str() << "wins approximately " << pct << "% of hands. "
-              << "Calculation took " << stats.second << " seconds. " << std::endl;
-    std::cout << std::endl;
+    HandRange range;
+    if(!range.parse(text)) {
+        std::cout << "  --> " << range.error() << ".  try again." << std::endl;
+        return false;
+    }
+    ranges_[seat] = range;
+    return true;
 }
-*/
 
-int PokerGame::monte_carlo_trial(const int& community_cards_left) {
-    deck_.repopulate();
-    for(const Card& c: players_[0].get_deck()) {
-        deck_.delete_card(c);
-    }
-    for(const Card& c: community_cards_) {
-        deck_.delete_card(c);
+bool PokerGame::has_ranges() const {
+    for(const HandRange& range: ranges_) {
+        if(!range.empty()) return true;
     }
-    for(int i_player = 1; i_player < players_.size(); i_player++) {
-        for(int i_card = 0; i_card < 2; ++i_card) {
-            players_[i_player].add_back(deck_.draw_delete_rand_card());
-        }
-    }
-    for(int i_card = 0; i_card < community_cards_left; ++i_card) community_cards_.push_back(deck_.draw_delete_rand_card());
-    std::vector<PokerHand> best_hands;
-    for(PokerHand& player: players_) {
-        std::vector<Card> tmp;
-        for(const Card& c: player.get_deck()) {
-            tmp.push_back(c);
-        }
-        for(const Card& c: community_cards_) {
-            tmp.push_back(c);
-        }
-        std::vector<std::vector<Card>> five_card_hands = combinations(tmp, 5);
-        PokerHand best_hand = find_best_hand(five_card_hands);
-        best_hands.push_back(best_hand);
-        //five_card_hands.clear();
+    return false;
+}
+
+/* one trial after another, with a running count */
+void PokerGame::monte_carlo_loop(const int& ntrials) {
+    std::cout << "Evaluating win probability using Monte Carlo." << std::endl;
+    EquityResult result = sample(ntrials, [ntrials](long long done, double) {
+        double pct_done = double(done) / double(ntrials) * 100.0e0;
+        std::cout << "  " << done << " out of " << ntrials
+                  << " trials (" << std::fixed << std::setprecision(2) << pct_done << "%)" << "\r" << std::flush;
+    });
+    std::cout << std::endl;
+    if(result.method == EquityResult::NONE) {
+        std::cout << "  " << result.error << "." << std::endl;
+        return;
     }
-    bool user_win = true;
-    //std::cout << "[0] " << best_hands[0].str() << " " << best_hands[0].show_score() << std::endl;
-    for(int i = 1; i < players_.size(); ++i) {
-        //std::cout << "[1] " << best_hands[i].str() << " " << best_hands[i].show_score() << std::endl;
-        if(best_hands[0] < best_hands[i]) {
-            user_win = false;
-        }
+    if(AllocationCounter::enabled()) {
+        std::cout << "  heap allocations in " << ntrials << " trials: " << result.nallocations << std::endl;
     }
-    //std::cout << user_win << std::endl;
-    for(int i = 1; i < players_.size(); ++i) players_[i].clear();
-    best_hands.clear();
-    for(int i_card = 0; i_card < community_cards_left; ++i_card) community_cards_.pop_back();
-    if(user_win) return 1;
-    return 0;
+    std::cout << std::endl;
+    print_equities(result.seats, result.nsamples);
+    std::cout << "Calculation took " << result.seconds << " seconds. " << std::endl;
+    std::cout << std::endl;
 }
 
+/* the strongest of the given 5 card hands.  they are scored as Hand values
+   and only the winner is wrapped in a PokerHand */
 PokerHand PokerGame::find_best_hand(const std::vector<std::vector<Card>>& hands_of_5) {
-    PokerHand best_hand = PokerHand(std::move(hands_of_5[0]));
-    best_hand.score_hand();
-    //for(const std::vector<Card>& this_hand: hands_of_5) {
-    for(int ihand = 1; ihand < hands_of_5.size(); ++ihand) {
-        //PokerHand tmp(hands_of_5[ihand]);
-        PokerHand tmp(std::move(hands_of_5[ihand]));
-        //PokerHand tmp(this_hand);
-        tmp.score_hand();
+    Hand best_hand = Hand::make(hands_of_5[0]);
+    best_hand.score();
+    for(size_t ihand = 1; ihand < hands_of_5.size(); ++ihand) {
+        Hand tmp = Hand::make(hands_of_5[ihand]);
+        tmp.score();
         if(tmp > best_hand) best_hand = tmp;
     }
-    return best_hand;
+    return PokerHand(best_hand);
 }
 
 Card PokerGame::get_card_from_user() {
@@ -242,50 +184,136 @@ Card PokerGame::get_card_from_user() {
     return deck_.generate_card(suit, rank);
 }
 
+/* seat 0 against the other seats as they stand, for the engine */
+EquityQuery PokerGame::query() const {
+    EquityQuery query;
+    query.hole_cards = players_[0].get_cards();
+    query.board = community_cards_;
+    query.ranges = ranges_;
+    query.nplayers = static_cast<int>(players_.size());
+    query.seed = seed_;
+    return query;
+}
+
 void PokerGame::monte_carlo_loop_thread(const int& ntrials) {
     std::cout << "Evaluating win probability using Monte Carlo." << std::endl;
-    long community_cards_left = 5 - community_cards_.size();
-    int nwin = 0;
-    int nthreads = std::thread::hardware_concurrency();
-    std::cout << "Number of threads: " << nthreads << std::endl;
+    std::cout << "Number of threads: " << ThreadPool::instance().size() + 1 << std::endl;
     std::cout << "Total number of trials: " << ntrials << std::endl;
-    std::vector<std::future<int>> wins;
-    auto t0 = std::chrono::high_resolution_clock::now();
-    for(int i = 0; i < nthreads; ++i) {
-        wins.push_back(std::async(std::launch::async, monte_carlo_omp, deck_, players_, community_cards_, community_cards_left, ntrials / nthreads));
+    std::cout << "Seed: " << seed_ << std::endl;
+    EquityResult result = sample(ntrials);
+    std::cout << std::endl;
+    if(result.method == EquityResult::NONE) {
+        std::cout << "  " << result.error << "." << std::endl;
+        return;
     }
-    for(int i = 0; i < nthreads; ++i) {
-        nwin += wins[i].get();
+    if(AllocationCounter::enabled()) {
+        std::cout << "  heap allocations in " << ntrials << " trials: " << result.nallocations << std::endl;
     }
     std::cout << std::endl;
-    //double pct = double(nwin) / double(ntrials * nthreads)  * 100.e0;
-    double pct = double(nwin) / double(ntrials)  * 100.e0;
-    auto tf = std::chrono::high_resolution_clock::now();
-    auto duration = (double)std::chrono::duration_cast<std::chrono::milliseconds>(tf -t0).count() / 1000.0e0;
+    print_equities(result.seats, result.nsamples);
+    std::cout << "Calculation took " << result.seconds << " seconds. " << std::endl;
     std::cout << std::endl;
-    std::cout << players_[0].str() << "wins approximately " << pct << "% of hands. "
-    << "Calculation took " << duration << " seconds. " << std::endl;
+}
+
+/* runs batches of trials until the 95% confidence interval of the first
+   player's equity is no wider than +/- target_half_width, or max_seconds pass */
+void PokerGame::monte_carlo_adaptive(double target_half_width, double max_seconds) {
+    std::cout << "Evaluating win probability using Monte Carlo." << std::endl;
+    std::cout << "Number of threads: " << ThreadPool::instance().size() + 1 << std::endl;
+    std::cout << "Target: +/- " << target_half_width * 100.e0 << "% at 95% confidence within "
+              << max_seconds << " seconds" << std::endl;
+    std::cout << "Seed: " << seed_ << std::endl;
+    EquityQuery q = query();
+    q.max_trials = std::numeric_limits<long long>::max();
+    q.max_seconds = max_seconds;
+    q.target_half_width = target_half_width;
+    q.progress = [](long long ntrials, double half_width) {
+        std::cout << "  " << ntrials << " trials, +/- " << std::fixed << std::setprecision(3) << half_width * 100.e0
+                  << "%" << "\r" << std::flush;
+    };
+    EquityResult result = EquityEngine(ThreadPool::instance()).monte_carlo(q);
+    std::cout << std::endl;
+    if(result.method == EquityResult::NONE) {
+        std::cout << "  " << result.error << "." << std::endl;
+        return;
+    }
+    if(AllocationCounter::enabled()) {
+        std::cout << "  heap allocations in " << result.nsamples << " trials: " << result.nallocations << std::endl;
+    }
     std::cout << std::endl;
+    print_equities(result.seats, result.nsamples);
+    std::cout << "Equity of " << players_[0].str() << "is within +/- " << result.half_width * 100.e0
+              << "% at 95% confidence after " << result.nsamples << " trials. "
+              << "Calculation took " << result.seconds << " seconds. " << std::endl;
+    std::cout << std::endl;
+}
+
+/* one line per seat: outright wins, split pots and equity (wins plus pot shares) */
+void PokerGame::print_equities(const std::vector<SeatTally>& tallies, long long ntrials) const {
+    for(size_t i = 0; i < tallies.size(); ++i) {
+        double pct_win = double(tallies[i].wins) / double(ntrials) * 100.e0;
+        double pct_tie = double(tallies[i].ties) / double(ntrials) * 100.e0;
+        double equity = (double(tallies[i].wins) + tallies[i].tie_share) / double(ntrials) * 100.e0;
+        std::string hand = i == 0 ? players_[0].str() : std::string("random ");
+        if(i > 0 && !ranges_[i].empty()) hand = "[" + ranges_[i].str() + "] ";
+        std::cout << "  seat " << i + 1 << " " << hand << "wins " << std::fixed << std::setprecision(3) << pct_win
+                  << "%, ties " << pct_tie << "%, equity " << equity << "%" << std::endl;
+    }
 }
 
+/* seat 0's outright wins in ntrials trials, -1 if the hand can't be sampled */
 int PokerGame::monte_carlo_loop2(const int& ntrials) {
     std::cout << "Evaluating win probability using Monte Carlo." << std::endl;
-    long community_cards_left = 5 - community_cards_.size();
-    int nwin = 0;
-    //auto t0 = std::chrono::high_resolution_clock::now();
-    for(int i = 0; i < ntrials; ++i) {
-        double pct_done = double(i + 1) / double(ntrials) * 100.0e0;
-        std::cout << "  " << i + 1 << " out of " << ntrials
-        << " trials (" << std::fixed << std::setprecision(2) << pct_done << "%)" << "\r";
-        nwin += monte_carlo_trial(community_cards_left);
+    EquityResult result = sample(ntrials);
+    if(result.method == EquityResult::NONE) return -1;
+    return static_cast<int>(result.seats[0].wins);
+}
+
+/* exactly ntrials trials of the hand as it stands, through the engine, which
+   checks the cards and ranges and spreads the trials over the pool */
+EquityResult PokerGame::sample(long long ntrials, const std::function<void(long long, double)>& progress) const {
+    EquityQuery q = query();
+    q.max_trials = ntrials;
+    q.max_seconds = std::numeric_limits<double>::infinity();
+    q.target_half_width = 0.0e0;
+    q.progress = progress;
+    return EquityEngine(ThreadPool::instance()).monte_carlo(q);
+}
+
+/* answers an all-in preflop question against random hands from the
+   precomputed table, false if there is no table or the question isn't one */
+bool PokerGame::lookup_preflop() {
+    EquityResult result = EquityEngine(ThreadPool::instance(), &PreflopTable::instance()).lookup_preflop(query());
+    if(result.method == EquityResult::NONE) return false;
+    std::cout << "Evaluating win probability from the preflop table." << std::endl;
+    std::cout << std::endl;
+    std::cout << players_[0].str() << "has equity " << std::fixed << std::setprecision(3) << result.equity * 100.e0
+              << "% against " << players_.size() - 1 << " random hands. "
+              << "Lookup took " << result.seconds * 1.0e6 << " microseconds. " << std::endl;
+    std::cout << std::endl;
+    return true;
+}
+
+/* exact equity of the first player, -1 if there are ranges or too many showdowns to enumerate */
+double PokerGame::enumerate_all() {
+    if(has_ranges()) return -1.0e0;
+    std::cout << "Evaluating win probability by exhaustive enumeration." << std::endl;
+    EquityQuery q = query();
+    q.max_showdowns = MAX_ENUMERATION_;
+    EquityResult result = EquityEngine(ThreadPool::instance()).enumerate(q);
+    if(result.method == EquityResult::NONE) {
+        if(!result.error.empty()) std::cout << "  " << result.error << std::endl;
+        else std::cout << "  " << double(result.nsamples) << " showdowns are too many to enumerate." << std::endl;
+        std::cout << std::endl;
+        return -1.0e0;
     }
+    std::cout << "Number of threads: " << ThreadPool::instance().size() + 1 << std::endl;
+    std::cout << "Total number of showdowns: " << result.nsamples << std::endl;
+    std::cout << "Distinct runouts up to suits: " << result.nrunouts << std::endl;
+    std::cout << std::endl;
+    std::cout << players_[0].str() << "wins exactly " << result.win * 100.e0 << "% and ties " << result.tie * 100.e0
+              << "% of hands, " << "equity " << result.equity * 100.e0 << "%. "
+              << "Calculation took " << result.seconds << " seconds. " << std::endl;
     std::cout << std::endl;
-    //double pct = double(nwin) / double(ntrials)  * 100.e0;
-    //auto tf = std::chrono::high_resolution_clock::now();
-    //auto duration = (double)std::chrono::duration_cast<std::chrono::milliseconds>(tf -t0).count();
-    //std::cout << std::endl;
-    //std::cout << players_[0].str() << "wins approximately " << pct << "% of hands. "
-    //<< "Calculation took " << duration / 1000 << " seconds. " << std::endl;
-    //std::cout << std::endl;
-    return nwin;
+    return result.equity;
 }
@@ -11,6 +11,11 @@
 
 #include "poker_hand.hpp"
 #include "deck.hpp"
+#include "trial_engine.hpp"
+#include "hand_range.hpp"
+#include "equity_engine.hpp"
+#include "rng.hpp"
+#include <memory>
 //#include <algorithm>
 
 class PokerGame
@@ -20,20 +25,30 @@ public:
     ~PokerGame();
     void init_hand();
     void init_community();
+    void init_ranges();
+    bool set_range(int seat, const std::string& text);
+    bool lookup_preflop();
     double enumerate_all();
     void monte_carlo_loop(const int& ntrials=25000);
     int monte_carlo_loop2(const int& ntrials=25000);
     void monte_carlo_loop_thread(const int& ntrials=25000);
-    void monte_carlo_omp_wrap(const int ntrials);
-    static int monte_carlo_omp(Deck deck, std::vector<PokerHand> players, std::vector<Card> community_cards,
-                                  int community_cards_left, const int ntrials);
+    void monte_carlo_adaptive(double target_half_width=0.005, double max_seconds=10.0);
+    void set_seed(uint64_t seed);
+    uint64_t get_seed() const;
+    static PokerHand find_best_hand(const std::vector<std::vector<Card>>& hands_of_5);
 private:
-    int monte_carlo_trial(const int& nleft_community);
     Deck deck_;
+    uint64_t seed_;
     std::vector<PokerHand> players_;
     std::vector<Card> community_cards_;
+    std::vector<HandRange> ranges_;
     Card get_card_from_user();
-    static PokerHand find_best_hand(const std::vector<std::vector<Card>>& hands_of_5);
+    bool has_ranges() const;
+    static const long long MAX_ENUMERATION_ = 200000000;
+    EquityQuery query() const;
+    EquityResult sample(long long ntrials,
+                        const std::function<void(long long, double)>& progress = nullptr) const;
+    void print_equities(const std::vector<SeatTally>& tallies, long long ntrials) const;
 };
 
 #endif /* poker_game_hpp */
\ No newline at end of file
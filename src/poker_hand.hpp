@@ -11,48 +11,37 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
 
-#include "deck.hpp"
+#include "card.hpp"
+#include "hand.hpp"
 
-class PokerHand : public Deck
+/* a hand for the console: the cards in a Hand plus printing.  anything that
+   runs per trial or per board works on Hand (or HandEvaluator) directly. */
+class PokerHand
 {
 public:
     PokerHand();
-    PokerHand(const bool& fill);
     PokerHand(const std::vector<Card>& cards);
-    PokerHand(const std::vector<Card>&& cards);
+    explicit PokerHand(const Hand& hand);
+    void add_back(const Card& c);
+    std::vector<Card> get_cards() const;
+    const Hand& hand() const;
+    long size() const;
+    std::string str() const;
     void print_all_hands();
-    void score_hand();
-    std::string show_score();
-    bool operator>(const PokerHand& other);
-    bool operator<(const PokerHand& other);
-    bool operator==(const PokerHand& other);
-    bool operator!=(const PokerHand& other);
-    bool operator>=(const PokerHand& other);
-    bool operator<=(const PokerHand& other);
+    bool score_hand();
+    int get_strength() const;
+    std::string show_score() const;
+    bool operator>(const PokerHand& other) const;
+    bool operator<(const PokerHand& other) const;
+    bool operator==(const PokerHand& other) const;
+    bool operator!=(const PokerHand& other) const;
+    bool operator>=(const PokerHand& other) const;
+    bool operator<=(const PokerHand& other) const;
 private:
     static const int SCORE_SIZE_ = 5;
-    int score_;
-    int special_value_1_;
-    int special_value_2_;
-    //static bool has_flush(const std::vector<Card>& cards);
-    //static bool has_straight(const std::vector<Card>& cards);
-    //static bool has_royal_flush(const std::vector<Card>& cards);
-    //static bool has_straight_flush(const std::vector<Card>& cards);
-    bool has_ace();
-    bool has_flush(const std::vector<int>& suits_count);
-    bool has_straight(const std::vector<int>& ranks_count);
-    bool has_royal_flush(const std::vector<int>& ranks_count);
-    bool has_straight_flush(const std::vector<int>& ranks_count);
-    int has_pairs(const std::vector<int>& ranks_count);
-    bool has_three_kind(const std::vector<int>& ranks_count);
-    bool has_four_kind(const std::vector<int>& ranks_count);
-    bool has_full_house(const std::vector<int>& ranks_count);
-    //static int has_x_of_a_kind(const int& x, const std::vector<Card>& cards);
-    //static std::pair<int, int> has_x_y_of_a_kind(const int& x, const int& y, const std::vector<Card>& cards);
-    bool set_hand_score(const std::string& hand);
-    void swap_ace_low();
-    void enumerate(std::vector<int>& ranks, std::vector<int>& suits);
+    Hand hand_;
 };
 
 #endif /* poker_hand_hpp */
@@ -0,0 +1,164 @@
+//
+//  preflop_table.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "preflop_table.hpp"
+#include "hand_range.hpp"
+#include "suit_isomorphism.hpp"
+
+const char PreflopTable::MAGIC_[8] = {'P', 'K', 'R', 'P', 'R', 'E', 'F', '\0'};
+
+PreflopTable::PreflopTable() {
+    data_ = nullptr;
+    size_ = 0;
+    vs_random_ = nullptr;
+    heads_up_ = nullptr;
+    trials_per_entry_ = 0;
+}
+
+PreflopTable::~PreflopTable() {
+    close();
+}
+
+/* the table the program answers preflop queries from.  it is opened on first
+   use from $POKER_PREFLOP_TABLE, or preflop.bin in the working directory.
+   the open runs in a static's initializer, which C++11 runs exactly once
+   even when pool workers make the first calls at the same time */
+PreflopTable& PreflopTable::instance() {
+    static PreflopTable table;
+    static const bool opened = [] {
+        const char* path = std::getenv("POKER_PREFLOP_TABLE");
+        return table.open(path ? path : "preflop.bin");
+    }();
+    (void)opened;
+    return table;
+}
+
+bool PreflopTable::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        error_ = "can't open " + path;
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        error_ = path + " is too short to be a preflop table";
+        return false;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) {
+        error_ = "can't map " + path;
+        return false;
+    }
+    data_ = data;
+    size_ = st.st_size;
+    const Header* header = static_cast<const Header*>(data_);
+    const unsigned char* bytes = static_cast<const unsigned char*>(data_);
+    size_t vs_random_size = sizeof(float) * (MAX_PLAYERS - MIN_PLAYERS + 1) * NUM_CLASSES;
+    size_t heads_up_size = sizeof(float) * NUM_COMBOS * NUM_COMBOS;
+    std::string error;
+    if(std::memcmp(header->magic, MAGIC_, sizeof(MAGIC_)) != 0) error = path + " is not a preflop table";
+    else if(header->version != VERSION) error = path + " has an unsupported version";
+    else if(header->header_size != sizeof(Header) || header->nclasses != NUM_CLASSES || header->ncombos != NUM_COMBOS
+            || header->min_players != MIN_PLAYERS || header->max_players != MAX_PLAYERS
+            || header->file_size != size_ || header->vs_random_offset + vs_random_size > size_
+            || header->heads_up_offset + heads_up_size > size_
+            || header->vs_random_offset % sizeof(float) || header->heads_up_offset % sizeof(float))
+        error = path + " has an unexpected layout";
+    else if(checksum(bytes + sizeof(Header), size_ - sizeof(Header)) != header->checksum)
+        error = path + " fails its checksum";
+    if(!error.empty()) {
+        close();
+        error_ = error;
+        return false;
+    }
+    vs_random_ = reinterpret_cast<const float*>(bytes + header->vs_random_offset);
+    heads_up_ = reinterpret_cast<const float*>(bytes + header->heads_up_offset);
+    trials_per_entry_ = header->trials_per_entry;
+    return true;
+}
+
+void PreflopTable::close() {
+    if(data_) munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+    vs_random_ = nullptr;
+    heads_up_ = nullptr;
+    trials_per_entry_ = 0;
+    error_.clear();
+}
+
+bool PreflopTable::loaded() const {
+    return data_ != nullptr;
+}
+
+const std::string& PreflopTable::error() const {
+    return error_;
+}
+
+/* Monte Carlo trials behind each multiway entry, 0 if the table is exact */
+uint64_t PreflopTable::trials_per_entry() const {
+    return trials_per_entry_;
+}
+
+/* equity of a b against nplayers - 1 random hands, -1 if there is no table */
+double PreflopTable::equity_vs_random(const Card& a, const Card& b, int nplayers) const {
+    if(!loaded() || nplayers < MIN_PLAYERS || nplayers > MAX_PLAYERS || a == b) return -1.0e0;
+    return vs_random_[(nplayers - MIN_PLAYERS) * NUM_CLASSES + SuitIsomorphism::preflop_class(a, b)];
+}
+
+/* heads-up equity of a1 a2 against b1 b2, -1 if there is no table or the hands overlap */
+double PreflopTable::equity(const Card& a1, const Card& a2, const Card& b1, const Card& b2) const {
+    if(!loaded() || a1 == a2 || b1 == b2) return -1.0e0;
+    return heads_up_[HandRange::combo_index(a1, a2) * NUM_COMBOS + HandRange::combo_index(b1, b2)];
+}
+
+uint64_t PreflopTable::checksum(const unsigned char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool PreflopTable::write(const std::string& path, const std::vector<float>& vs_random,
+                         const std::vector<float>& heads_up, uint64_t trials_per_entry) {
+    if(vs_random.size() != size_t(MAX_PLAYERS - MIN_PLAYERS + 1) * NUM_CLASSES
+       || heads_up.size() != size_t(NUM_COMBOS) * NUM_COMBOS) return false;
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC_, sizeof(MAGIC_));
+    header.version = VERSION;
+    header.header_size = sizeof(Header);
+    header.nclasses = NUM_CLASSES;
+    header.min_players = MIN_PLAYERS;
+    header.max_players = MAX_PLAYERS;
+    header.ncombos = NUM_COMBOS;
+    header.vs_random_offset = sizeof(Header);
+    header.heads_up_offset = header.vs_random_offset + sizeof(float) * vs_random.size();
+    header.file_size = header.heads_up_offset + sizeof(float) * heads_up.size();
+    header.trials_per_entry = trials_per_entry;
+    std::vector<unsigned char> payload(header.file_size - sizeof(Header));
+    std::memcpy(payload.data(), vs_random.data(), sizeof(float) * vs_random.size());
+    std::memcpy(payload.data() + sizeof(float) * vs_random.size(), heads_up.data(), sizeof(float) * heads_up.size());
+    header.checksum = checksum(payload.data(), payload.size());
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+    return static_cast<bool>(out);
+}
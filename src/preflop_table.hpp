@@ -0,0 +1,78 @@
+//
+//  preflop_table.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef preflop_table_hpp
+#define preflop_table_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "card.hpp"
+
+/* precomputed all-in preflop equities, read from a file made by
+   tools/gen_preflop.  the file is mapped read only, so opening it costs a
+   checksum pass and every query after that is one load:
+
+     header            magic, version, sizes, offsets, checksum
+     vs_random[9][169] equity of each starting hand class against 1 to 9
+                       random hands (2 to 10 players)
+     heads_up[1326][1326]
+                       equity of one combo against another, -1 where the
+                       combos share a card
+
+   classes are SuitIsomorphism::preflop_class() and combos are
+   HandRange::combo_index().  all equities are floats in [0, 1] and the
+   checksum is FNV-1a over everything after the header. */
+class PreflopTable
+{
+public:
+    static const uint32_t VERSION = 1;
+    static const int MIN_PLAYERS = 2;
+    static const int MAX_PLAYERS = 10;
+    static const int NUM_CLASSES = 169;
+    static const int NUM_COMBOS = 1326;
+    PreflopTable();
+    ~PreflopTable();
+    static PreflopTable& instance();
+    bool open(const std::string& path);
+    void close();
+    bool loaded() const;
+    const std::string& error() const;
+    uint64_t trials_per_entry() const;
+    double equity_vs_random(const Card& a, const Card& b, int nplayers) const;
+    double equity(const Card& a1, const Card& a2, const Card& b1, const Card& b2) const;
+    static bool write(const std::string& path, const std::vector<float>& vs_random,
+                      const std::vector<float>& heads_up, uint64_t trials_per_entry);
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint32_t nclasses;
+        uint32_t min_players;
+        uint32_t max_players;
+        uint32_t ncombos;
+        uint64_t vs_random_offset;
+        uint64_t heads_up_offset;
+        uint64_t file_size;
+        uint64_t trials_per_entry;
+        uint64_t checksum;
+    };
+    static const char MAGIC_[8];
+    void* data_;
+    size_t size_;
+    const float* vs_random_;
+    const float* heads_up_;
+    uint64_t trials_per_entry_;
+    std::string error_;
+    PreflopTable(const PreflopTable&);
+    PreflopTable& operator=(const PreflopTable&);
+    static uint64_t checksum(const unsigned char* data, size_t size);
+};
+
+#endif /* preflop_table_hpp */
@@ -0,0 +1,91 @@
+//
+//  rng.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef rng_hpp
+#define rng_hpp
+
+#include <cstdint>
+
+/* xoshiro256** (Blackman and Vigna).  four words of state, a handful of
+   shifts and xors per draw.  satisfies UniformRandomBitGenerator so it can
+   be handed to std::shuffle and the std distributions as well. */
+class Xoshiro256
+{
+public:
+    typedef uint64_t result_type;
+    Xoshiro256() { seed(0); }
+    explicit Xoshiro256(uint64_t seed_value) { seed(seed_value); }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~uint64_t(0); }
+    result_type operator()() { return next(); }
+
+    /* fills the state from splitmix64 so any seed, even 0, gives a good state */
+    void seed(uint64_t seed_value) {
+        for(int i = 0; i < 4; ++i) {
+            seed_value += 0x9e3779b97f4a7c15ull;
+            uint64_t z = seed_value;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            state_[i] = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    /* advances the state by 2^128 draws.  calling it i times on a copy of a
+       seeded generator gives the i-th of 2^128 non-overlapping streams. */
+    void jump() {
+        static const uint64_t JUMP[4] = {0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+                                         0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+        uint64_t s[4] = {0, 0, 0, 0};
+        for(int i = 0; i < 4; ++i) {
+            for(int b = 0; b < 64; ++b) {
+                if(JUMP[i] & (uint64_t(1) << b)) {
+                    for(int j = 0; j < 4; ++j) s[j] ^= state_[j];
+                }
+                next();
+            }
+        }
+        for(int j = 0; j < 4; ++j) state_[j] = s[j];
+    }
+
+    /* generator for worker number stream_index of a seeded run */
+    static Xoshiro256 stream(uint64_t seed_value, int stream_index) {
+        Xoshiro256 rng(seed_value);
+        for(int i = 0; i < stream_index; ++i) rng.jump();
+        return rng;
+    }
+
+    /* unbiased draw from [0, range) by multiply and reject (Lemire), range > 0 */
+    uint32_t bounded(uint32_t range) {
+        uint64_t m = (next() >> 32) * uint64_t(range);
+        uint32_t low = static_cast<uint32_t>(m);
+        if(low < range) {
+            uint32_t threshold = (0u - range) % range;
+            while(low < threshold) {
+                m = (next() >> 32) * uint64_t(range);
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+private:
+    uint64_t state_[4];
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+#endif /* rng_hpp */
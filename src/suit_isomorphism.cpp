@@ -0,0 +1,120 @@
+//
+//  suit_isomorphism.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <algorithm>
+
+#include "suit_isomorphism.hpp"
+
+SuitIsomorphism::SuitIsomorphism(const std::vector<int>& group_sizes) : group_sizes_(group_sizes) {
+    uint64_t groups[MAX_GROUPS] = {0};
+    if(group_sizes_.empty() || group_sizes_.size() > MAX_GROUPS) return;
+    add_classes(groups, 0, 0, group_sizes_[0], 0);
+    // number the classes in order of their canonical masks
+    representatives_.resize(classes_.size());
+    int i = 0;
+    for(auto& c: classes_) {
+        c.second = i;
+        representatives_[i++] = c.first;
+    }
+}
+
+/* deals every card set of the shape and keeps its canonical form */
+void SuitIsomorphism::add_classes(uint64_t* groups, int group, int first_card, int ncards_left, uint64_t used) {
+    int ngroups = static_cast<int>(group_sizes_.size());
+    if(ncards_left == 0) {
+        if(group + 1 < ngroups) {
+            add_classes(groups, group + 1, 0, group_sizes_[group + 1], used);
+            return;
+        }
+        std::vector<uint64_t> canonical(ngroups);
+        canonicalize(groups, ngroups, canonical.data());
+        classes_.insert(std::make_pair(canonical, 0));
+        return;
+    }
+    for(int c = first_card; c <= Card::NUM_CARDS - ncards_left; ++c) {
+        uint64_t bit = uint64_t(1) << c;
+        if(used & bit) continue;
+        groups[group] |= bit;
+        add_classes(groups, group, c + 1, ncards_left - 1, used | bit);
+        groups[group] &= ~bit;
+    }
+}
+
+int SuitIsomorphism::nclasses() const {
+    return static_cast<int>(representatives_.size());
+}
+
+/* dense class number of groups (one mask per group of the shape), -1 if it doesn't fit the shape */
+int SuitIsomorphism::index(const uint64_t* groups) const {
+    int ngroups = static_cast<int>(group_sizes_.size());
+    std::vector<uint64_t> canonical(ngroups);
+    canonicalize(groups, ngroups, canonical.data());
+    auto it = classes_.find(canonical);
+    return it == classes_.end() ? -1 : it->second;
+}
+
+/* the canonical groups of a class */
+const std::vector<uint64_t>& SuitIsomorphism::representative(int index) const {
+    return representatives_[index];
+}
+
+unsigned SuitIsomorphism::rank_mask(uint64_t cards, int suit) {
+    unsigned mask = 0;
+    for(int r = 0; r < Card::NUM_RANKS; ++r) {
+        if(cards & (uint64_t(1) << (r * Card::NUM_SUITS + suit))) mask |= 1u << r;
+    }
+    return mask;
+}
+
+/* suit_map[s] is the canonical suit that suit s is renamed to */
+void SuitIsomorphism::canonical_suits(const uint64_t* groups, int ngroups, int* suit_map) {
+    unsigned tuples[Card::NUM_SUITS][MAX_GROUPS];
+    int order[Card::NUM_SUITS];
+    for(int s = 0; s < Card::NUM_SUITS; ++s) {
+        order[s] = s;
+        for(int g = 0; g < ngroups; ++g) tuples[s][g] = rank_mask(groups[g], s);
+    }
+    auto before = [&tuples, ngroups](int a, int b) {
+        for(int g = 0; g < ngroups; ++g) {
+            if(tuples[a][g] != tuples[b][g]) return tuples[a][g] > tuples[b][g];
+        }
+        return a < b;
+    };
+    std::sort(order, order + Card::NUM_SUITS, before);
+    for(int i = 0; i < Card::NUM_SUITS; ++i) suit_map[order[i]] = i;
+}
+
+void SuitIsomorphism::canonicalize(const uint64_t* groups, int ngroups, uint64_t* canonical) {
+    int suit_map[Card::NUM_SUITS];
+    canonical_suits(groups, ngroups, suit_map);
+    for(int g = 0; g < ngroups; ++g) canonical[g] = map_suits(groups[g], suit_map);
+}
+
+uint64_t SuitIsomorphism::map_suits(uint64_t cards, const int* suit_map) {
+    uint64_t mapped = 0;
+    while(cards) {
+        int c = __builtin_ctzll(cards);
+        cards &= cards - 1;
+        mapped |= uint64_t(1) << (c - c % Card::NUM_SUITS + suit_map[c % Card::NUM_SUITS]);
+    }
+    return mapped;
+}
+
+uint64_t SuitIsomorphism::card_mask(const std::vector<Card>& cards) {
+    uint64_t mask = 0;
+    for(const Card& c: cards) mask |= uint64_t(1) << c.get_index();
+    return mask;
+}
+
+/* cell of the 13x13 starting hand grid: pairs on the diagonal, suited hands
+   above it (row = higher rank), offsuit hands below it */
+int SuitIsomorphism::preflop_class(const Card& a, const Card& b) {
+    int high = std::max(a.get_rank(), b.get_rank());
+    int low = std::min(a.get_rank(), b.get_rank());
+    if(a.get_suit() == b.get_suit()) return high * Card::NUM_RANKS + low;
+    return low * Card::NUM_RANKS + high;
+}
@@ -0,0 +1,49 @@
+//
+//  suit_isomorphism.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef suit_isomorphism_hpp
+#define suit_isomorphism_hpp
+
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include "card.hpp"
+
+/* maps cards that only differ by a renaming of suits onto one canonical
+   form.  cards come in groups whose order matters (hole cards, board, dead
+   cards ...), each group a 64 bit mask with bit get_index() set per card.
+   every suit gets the tuple of its rank masks in each group, and suits are
+   renamed in decreasing order of that tuple, so AhKh on 2c7d9s and AsKs on
+   2h7c9d come out the same.
+
+   an instance numbers the classes of one shape of groups densely, e.g. {2}
+   has 169 classes and {3} (a flop) has 1755, in increasing order of their
+   canonical masks.  building one enumerates every deal of that shape. */
+class SuitIsomorphism
+{
+public:
+    static const int MAX_GROUPS = 4;
+    static const int NUM_PREFLOP_CLASSES = 169;
+    explicit SuitIsomorphism(const std::vector<int>& group_sizes);
+    int nclasses() const;
+    int index(const uint64_t* groups) const;
+    const std::vector<uint64_t>& representative(int index) const;
+    static void canonical_suits(const uint64_t* groups, int ngroups, int* suit_map);
+    static void canonicalize(const uint64_t* groups, int ngroups, uint64_t* canonical);
+    static uint64_t map_suits(uint64_t cards, const int* suit_map);
+    static uint64_t card_mask(const std::vector<Card>& cards);
+    static int preflop_class(const Card& a, const Card& b);
+private:
+    std::vector<int> group_sizes_;
+    std::map<std::vector<uint64_t>, int> classes_;
+    std::vector<std::vector<uint64_t>> representatives_;
+    void add_classes(uint64_t* groups, int group, int first_card, int ncards_left, uint64_t used);
+    static unsigned rank_mask(uint64_t cards, int suit);
+};
+
+#endif /* suit_isomorphism_hpp */
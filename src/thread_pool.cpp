@@ -0,0 +1,83 @@
+//
+//  thread_pool.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(int nworkers) {
+    stop_ = false;
+    for(int i = 0; i < nworkers; ++i) {
+        workers_.push_back(std::thread(&ThreadPool::worker_loop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_ready_.notify_all();
+    for(std::thread& t: workers_) t.join();
+}
+
+/* the submitting thread also works on its jobs, so one core is left for it */
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(std::max(1, static_cast<int>(std::thread::hardware_concurrency())) - 1);
+    return pool;
+}
+
+/* worker threads, not counting the thread that calls parallel_for */
+int ThreadPool::size() const {
+    return static_cast<int>(workers_.size());
+}
+
+void ThreadPool::parallel_for(long nchunks, const std::function<void(long, int)>& body) {
+    if(nchunks <= 0) return;
+    Job job;
+    job.body = &body;
+    job.nchunks = nchunks;
+    job.next_chunk = 0;
+    job.nusers = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(&job);
+    }
+    work_ready_.notify_all();
+    run_chunks(job, size());
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::deque<Job*>::iterator pos = std::find(std::begin(jobs_), std::end(jobs_), &job);
+    if(pos != std::end(jobs_)) jobs_.erase(pos);
+    job_released_.wait(lock, [&job] { return job.nusers == 0; });
+}
+
+void ThreadPool::worker_loop(int slot) {
+    for(;;) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if(stop_) return;
+            job = jobs_.front();
+            ++job->nusers;
+        }
+        run_chunks(*job, slot);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!jobs_.empty() && jobs_.front() == job) jobs_.pop_front();
+            --job->nusers;
+        }
+        job_released_.notify_all();
+    }
+}
+
+void ThreadPool::run_chunks(Job& job, int slot) {
+    long chunk;
+    while((chunk = job.next_chunk.fetch_add(1)) < job.nchunks) {
+        (*job.body)(chunk, slot);
+    }
+}
@@ -0,0 +1,50 @@
+//
+//  thread_pool.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef thread_pool_hpp
+#define thread_pool_hpp
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+/* a fixed set of worker threads that lives for the whole process.  a job is
+   split into numbered chunks; every worker that is idle (and the thread that
+   submitted the job) keeps claiming the next unclaimed chunk from the job's
+   counter until none are left, so slow or descheduled threads never hold up
+   the rest.  body(chunk, slot) gets a slot number in [0, size()] that is
+   unique among the threads running the same job, for per-thread scratch. */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int nworkers);
+    ~ThreadPool();
+    static ThreadPool& instance();
+    int size() const;
+    void parallel_for(long nchunks, const std::function<void(long, int)>& body);
+private:
+    struct Job {
+        const std::function<void(long, int)>* body;
+        long nchunks;
+        std::atomic<long> next_chunk;
+        int nusers;
+    };
+    std::vector<std::thread> workers_;
+    std::deque<Job*> jobs_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable job_released_;
+    bool stop_;
+    void worker_loop(int slot);
+    static void run_chunks(Job& job, int slot);
+};
+
+#endif /* thread_pool_hpp */
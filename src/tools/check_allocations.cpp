@@ -0,0 +1,93 @@
+//
+//  check_allocations.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <limits>
+
+#include "card.hpp"
+#include "hand_range.hpp"
+#include "alloc_counter.hpp"
+#include "equity_engine.hpp"
+#include "thread_pool.hpp"
+
+/* regression check for the allocation free trial loop.
+
+     check_allocations
+
+   must be built with -DPOKER_COUNT_ALLOCATIONS (tools/compile.sh does), so
+   that every operator new is counted.  each spot below is sampled by
+   EquityEngine::monte_carlo, which adds up what every worker allocated
+   inside TrialEngine::run(), and that has to be 0: the engines, decks and
+   batches are all set up before the first trial.  exits 1 on the first
+   spot that allocates, or if the counter isn't compiled in. */
+
+namespace {
+
+struct Spot {
+    const char* hole;
+    const char* board;
+    const char* dead;
+    int nplayers;
+    const char* range;
+};
+
+const Spot SPOTS[] = {
+    {"AhKh", "", "", 2, ""},
+    {"AhKh", "2c7d9s", "", 6, ""},
+    {"QsQd", "Jh8c5d", "2s3s", 3, ""},
+    {"9c9d", "", "", 4, "QQ+, AKs, 76s-54s:0.5"},
+};
+
+std::vector<Card> cards_of(const std::string& text) {
+    std::vector<Card> cards;
+    for(size_t i = 0; i + 1 < text.size(); i += 2) {
+        Card c;
+        if(Card::from_str(text.substr(i, 2), c)) cards.push_back(c);
+    }
+    return cards;
+}
+
+}
+
+int main() {
+    if(!AllocationCounter::enabled()) {
+        std::cout << "built without -DPOKER_COUNT_ALLOCATIONS, nothing is counted" << std::endl;
+        return 1;
+    }
+    EquityEngine engine(ThreadPool::instance());
+    for(const Spot& spot: SPOTS) {
+        EquityQuery query;
+        query.hole_cards = cards_of(spot.hole);
+        query.board = cards_of(spot.board);
+        query.dead_cards = cards_of(spot.dead);
+        query.nplayers = spot.nplayers;
+        if(*spot.range) {
+            query.ranges.resize(spot.nplayers);
+            for(int seat = 1; seat < spot.nplayers; ++seat) query.ranges[seat].parse(spot.range);
+        }
+        query.max_trials = 200000;
+        query.max_seconds = std::numeric_limits<double>::infinity();
+        query.target_half_width = 0.0e0;
+        query.seed = 2016;
+        std::string name = std::string(spot.hole) + " | " + spot.board + " | dead " + spot.dead + " | "
+                           + std::to_string(spot.nplayers) + " players" + (*spot.range ? " | " : "") + spot.range;
+        EquityResult result = engine.monte_carlo(query);
+        if(result.method != EquityResult::MONTE_CARLO) {
+            std::cout << name << ": " << result.error << std::endl;
+            return 1;
+        }
+        std::cout << name << ": " << result.nsamples << " trials, " << result.nallocations << " heap allocations";
+        if(result.nallocations != 0) {
+            std::cout << " -- the trial loop allocates" << std::endl;
+            return 1;
+        }
+        std::cout << " ok" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+//
+//  check_enumeration.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+#include "card.hpp"
+#include "hand_evaluator.hpp"
+#include "misc.hpp"
+#include "equity_engine.hpp"
+#include "thread_pool.hpp"
+
+/* regression check for exact enumeration.
+
+     check_enumeration
+
+   every spot below is enumerated by EquityEngine, which skips runouts that
+   a suit symmetry maps onto others and weights the rest, and again by
+   brute force over every runout and every set of opponent hands with no
+   symmetries at all.  the counts must agree exactly.  most spots have dead
+   cards, which a symmetry has to leave dead (and the board on the board).
+   runout_index() is checked to invert runout() and to reject runouts that
+   aren't one.  exits 1 on the first disagreement. */
+
+namespace {
+
+struct Spot {
+    const char* hole;
+    const char* board;
+    const char* dead;
+    int nplayers;
+};
+
+const Spot SPOTS[] = {
+    // a heart/spade swap trades board cards for dead ones
+    {"2c3d", "AhThKs4c", "AsTsKh", 2},
+    {"9c9d", "KhQs2h3s", "KsQh2s3h", 2},
+    // and one that maps board onto board and dead onto dead, so it counts
+    {"AcAd", "2h2s7h7s", "KhKs", 2},
+    {"AsKs", "2s7s9s", "3s4h", 2},
+    {"5h5d", "QhJh2c7d", "QcJc", 3},
+    {"AhKh", "2c7d9s", "", 2},
+};
+
+std::vector<Card> cards_of(const std::string& text) {
+    std::vector<Card> cards;
+    for(size_t i = 0; i + 1 < text.size(); i += 2) {
+        Card c;
+        if(Card::from_str(text.substr(i, 2), c)) cards.push_back(c);
+    }
+    return cards;
+}
+
+/* seat 0 against every unordered set of nopponents hands from left, each set once */
+void tally_opponents(const std::vector<Card>& left, const Card* board, const std::vector<Card>& hole,
+                     int first_pair, uint64_t used, int nopponents, int best, int nbest, ShowdownCounts& counts) {
+    Card hand[7];
+    for(int i = 0; i < 5; ++i) hand[i] = board[i];
+    if(nopponents == 0) {
+        hand[5] = hole[0];
+        hand[6] = hole[1];
+        int hero = HandEvaluator::evaluate(hand, 7);
+        if(best > hero) {
+            ++counts.losses;
+        } else if(best == hero) {
+            ++counts.ties;
+            counts.tie_share += 1.0e0 / (nbest + 1);
+        } else {
+            ++counts.wins;
+        }
+        return;
+    }
+    int n = static_cast<int>(left.size());
+    int pair = 0;
+    for(int i = 0; i < n; ++i) {
+        for(int j = i + 1; j < n; ++j, ++pair) {
+            if(pair < first_pair || (used & ((uint64_t(1) << i) | (uint64_t(1) << j)))) continue;
+            hand[5] = left[i];
+            hand[6] = left[j];
+            int strength = HandEvaluator::evaluate(hand, 7);
+            int count = strength > best ? 1 : (strength == best ? nbest + 1 : nbest);
+            tally_opponents(left, board, hole, pair + 1, used | (uint64_t(1) << i) | (uint64_t(1) << j), nopponents - 1,
+                            std::max(best, strength), count, counts);
+        }
+    }
+}
+
+ShowdownCounts brute_force(const EquityQuery& query, const std::vector<Card>& remaining) {
+    ShowdownCounts counts = {0, 0, 0, 0.0e0};
+    int missing = 5 - static_cast<int>(query.board.size());
+    for_each_combination(remaining, missing, [&](const Card* runout, int k) {
+        Card board[5];
+        int nboard = 0;
+        for(const Card& c: query.board) board[nboard++] = c;
+        for(int i = 0; i < k; ++i) board[nboard++] = runout[i];
+        std::vector<Card> left;
+        for(const Card& c: remaining) {
+            if(std::find(runout, runout + k, c) == runout + k) left.push_back(c);
+        }
+        tally_opponents(left, board, query.hole_cards, 0, 0, query.nplayers - 1, 0, 0, counts);
+    });
+    return counts;
+}
+
+bool check_runout_index(const EquityEngine& engine, const EquityQuery& query, const std::vector<Card>& remaining) {
+    uint64_t nrunouts = engine.count_runouts(query);
+    for(uint64_t index = 0; index < nrunouts; ++index) {
+        if(engine.runout_index(query, engine.runout(query, index)) != index) return false;
+    }
+    if(query.board.size() == 5) return true;
+    std::vector<Card> runout = engine.runout(query, 0);
+    std::vector<Card> bad = runout;
+    bad[0] = query.hole_cards[0];
+    if(engine.runout_index(query, bad) != nrunouts) return false;
+    bad = runout;
+    bad.push_back(remaining.back());
+    if(engine.runout_index(query, bad) != nrunouts) return false;
+    if(runout.size() > 1) {
+        bad = runout;
+        bad[1] = bad[0];
+        if(engine.runout_index(query, bad) != nrunouts) return false;
+    }
+    return true;
+}
+
+}
+
+int main() {
+    EquityEngine engine(ThreadPool::instance());
+    for(const Spot& spot: SPOTS) {
+        EquityQuery query;
+        query.hole_cards = cards_of(spot.hole);
+        query.board = cards_of(spot.board);
+        query.dead_cards = cards_of(spot.dead);
+        query.nplayers = spot.nplayers;
+        std::string name = std::string(spot.hole) + " | " + spot.board + " | dead " + spot.dead + " | "
+                           + std::to_string(spot.nplayers) + " players";
+        EquityResult result = engine.enumerate(query);
+        if(result.method != EquityResult::ENUMERATION) {
+            std::cout << name << ": " << result.error << std::endl;
+            return 1;
+        }
+        std::vector<Card> remaining;
+        for(int i = 0; i < Card::NUM_CARDS; ++i) {
+            Card c = Card::from_index(i);
+            if(std::find(std::begin(query.hole_cards), std::end(query.hole_cards), c) == std::end(query.hole_cards)
+               && std::find(std::begin(query.board), std::end(query.board), c) == std::end(query.board)
+               && std::find(std::begin(query.dead_cards), std::end(query.dead_cards), c) == std::end(query.dead_cards))
+                remaining.push_back(c);
+        }
+        ShowdownCounts expected = brute_force(query, remaining);
+        const ShowdownCounts& got = result.counts;
+        bool same = got.wins == expected.wins && got.ties == expected.ties && got.losses == expected.losses
+                    && std::fabs(got.tie_share - expected.tie_share) <= 1.0e-9 * (1.0e0 + expected.tie_share);
+        double total = double(expected.wins + expected.ties + expected.losses);
+        std::cout << name << ": equity " << result.equity << ", brute force "
+                  << (double(expected.wins) + expected.tie_share) / total;
+        if(!same) {
+            std::cout << " -- counts disagree" << std::endl;
+            return 1;
+        }
+        if(!check_runout_index(engine, query, remaining)) {
+            std::cout << " -- runout_index is not the inverse of runout" << std::endl;
+            return 1;
+        }
+        std::cout << " ok" << std::endl;
+    }
+    return 0;
+}
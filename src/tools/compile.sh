@@ -0,0 +1,6 @@
+# builds the offline tools against the calculator's sources (everything but main.cpp):
+# the preflop table generator and the exact enumeration and allocation regression checks
+g++ $(ls ../*.cpp | grep -v '/main.cpp$') gen_preflop.cpp -I.. -lpthread -O3 -std=c++11 -o gen_preflop
+g++ $(ls ../*.cpp | grep -v '/main.cpp$') check_enumeration.cpp -I.. -lpthread -O3 -std=c++11 -o check_enumeration
+g++ $(ls ../*.cpp | grep -v '/main.cpp$') check_allocations.cpp -I.. -lpthread -O3 -std=c++11 -DPOKER_COUNT_ALLOCATIONS \
+    -o check_allocations
@@ -0,0 +1,159 @@
+//
+//  gen_preflop.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "card.hpp"
+#include "deck.hpp"
+#include "hand_evaluator.hpp"
+#include "hand_range.hpp"
+#include "suit_isomorphism.hpp"
+#include "trial_engine.hpp"
+#include "thread_pool.hpp"
+#include "preflop_table.hpp"
+
+/* writes the preflop table that PreflopTable maps at startup.
+
+     gen_preflop [output] [multiway trials] [heads-up trials]
+
+   heads-up equities are enumerated over every board unless heads-up trials
+   is given, once per class of the two hands up to suits.  the 2 player
+   column of vs_random averages the heads-up matrix; 3 to 10 players can't
+   be enumerated and get multiway trials (default 1000000) of Monte Carlo. */
+
+namespace {
+
+const uint64_t SEED = 20160719;
+
+/* equity of a against b over every board */
+double exact_heads_up(const Card* a, const Card* b) {
+    Card rest[Card::NUM_CARDS];
+    int nrest = 0;
+    for(int i = 0; i < Card::NUM_CARDS; ++i) {
+        Card c = Card::from_index(i);
+        if(c != a[0] && c != a[1] && c != b[0] && c != b[1]) rest[nrest++] = c;
+    }
+    double wins = 0, ties = 0, nboards = 0;
+    // each loop adds its card to the state of the one outside it, so a board costs one add instead of five
+    HandEvaluator::State board[6] = {{0, 0, 0}};
+    for(int i = 0; i < nrest; ++i) {
+        board[1] = HandEvaluator::add(board[0], rest[i]);
+        for(int j = i + 1; j < nrest; ++j) {
+            board[2] = HandEvaluator::add(board[1], rest[j]);
+            for(int k = j + 1; k < nrest; ++k) {
+                board[3] = HandEvaluator::add(board[2], rest[k]);
+                for(int l = k + 1; l < nrest; ++l) {
+                    board[4] = HandEvaluator::add(board[3], rest[l]);
+                    for(int m = l + 1; m < nrest; ++m) {
+                        board[5] = HandEvaluator::add(board[4], rest[m]);
+                        int sa = HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board[5], a[0]), a[1]));
+                        int sb = HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board[5], b[0]), b[1]));
+                        if(sa > sb) ++wins;
+                        else if(sa == sb) ++ties;
+                        ++nboards;
+                    }
+                }
+            }
+        }
+    }
+    return (wins + 0.5e0 * ties) / nboards;
+}
+
+/* equity of hero against nplayers - 1 hands, random or from the given ranges.  every
+   entry seeds its own generator, jumping ahead to stream number entry would cost O(entry) */
+double sampled_equity(const std::vector<Card>& hero, int nplayers, const std::vector<HandRange>& ranges,
+                      long long ntrials, long entry) {
+    TrialEngine engine(Deck(), hero, std::vector<Card>(), nplayers, SEED + entry, 0, ranges);
+    engine.run(ntrials);
+    return (engine.tally(0).wins + engine.tally(0).tie_share) / double(ntrials);
+}
+
+std::vector<Card> cards_of(uint64_t mask) {
+    std::vector<Card> cards;
+    for(int i = 0; i < Card::NUM_CARDS; ++i) {
+        if(mask & (uint64_t(1) << i)) cards.push_back(Card::from_index(i));
+    }
+    return cards;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "preflop.bin";
+    long long multiway_trials = argc > 2 ? static_cast<long long>(std::stod(argv[2])) : 1000000;
+    long long heads_up_trials = argc > 3 ? static_cast<long long>(std::stod(argv[3])) : 0;
+    ThreadPool& pool = ThreadPool::instance();
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    // one equity per class of (hand, hand) up to suits, spread over the whole matrix
+    SuitIsomorphism matchups(std::vector<int>{2, 2});
+    std::cout << "heads-up classes: " << matchups.nclasses() << std::endl;
+    std::vector<float> class_equity(matchups.nclasses());
+    pool.parallel_for(matchups.nclasses(), [&](long k, int) {
+        std::vector<Card> a = cards_of(matchups.representative(static_cast<int>(k))[0]);
+        std::vector<Card> b = cards_of(matchups.representative(static_cast<int>(k))[1]);
+        if(heads_up_trials > 0) {
+            std::vector<HandRange> ranges(2);
+            ranges[1].set_weight(b[0], b[1], 1.0e0);
+            class_equity[k] = static_cast<float>(sampled_equity(a, 2, ranges, heads_up_trials, k));
+        } else {
+            class_equity[k] = static_cast<float>(exact_heads_up(a.data(), b.data()));
+        }
+    });
+    std::vector<float> heads_up(PreflopTable::NUM_COMBOS * PreflopTable::NUM_COMBOS, -1.0f);
+    std::vector<double> sum_vs_random(PreflopTable::NUM_COMBOS, 0.0e0);
+    for(int a_hi = 1; a_hi < Card::NUM_CARDS; ++a_hi) {
+        for(int a_lo = 0; a_lo < a_hi; ++a_lo) {
+            uint64_t groups[2] = {(uint64_t(1) << a_hi) | (uint64_t(1) << a_lo), 0};
+            int a = HandRange::combo_index(Card::from_index(a_hi), Card::from_index(a_lo));
+            for(int b_hi = 1; b_hi < Card::NUM_CARDS; ++b_hi) {
+                for(int b_lo = 0; b_lo < b_hi; ++b_lo) {
+                    groups[1] = (uint64_t(1) << b_hi) | (uint64_t(1) << b_lo);
+                    if(groups[0] & groups[1]) continue;
+                    int b = HandRange::combo_index(Card::from_index(b_hi), Card::from_index(b_lo));
+                    float equity = class_equity[matchups.index(groups)];
+                    heads_up[a * PreflopTable::NUM_COMBOS + b] = equity;
+                    sum_vs_random[a] += equity;
+                }
+            }
+        }
+    }
+
+    // every class against random hands, from one combo of the class
+    std::vector<std::vector<Card>> class_hands(PreflopTable::NUM_CLASSES);
+    for(int hi = 1; hi < Card::NUM_CARDS; ++hi) {
+        for(int lo = 0; lo < hi; ++lo) {
+            Card a = Card::from_index(hi), b = Card::from_index(lo);
+            std::vector<Card>& hand = class_hands[SuitIsomorphism::preflop_class(a, b)];
+            if(hand.empty()) hand = std::vector<Card>{a, b};
+        }
+    }
+    int nplayer_counts = PreflopTable::MAX_PLAYERS - PreflopTable::MIN_PLAYERS + 1;
+    std::vector<float> vs_random(nplayer_counts * PreflopTable::NUM_CLASSES);
+    pool.parallel_for(nplayer_counts * PreflopTable::NUM_CLASSES, [&](long entry, int) {
+        int nplayers = PreflopTable::MIN_PLAYERS + static_cast<int>(entry / PreflopTable::NUM_CLASSES);
+        const std::vector<Card>& hand = class_hands[entry % PreflopTable::NUM_CLASSES];
+        if(nplayers == 2) {
+            // a hand meets C(50, 2) = 1225 opponent combos
+            vs_random[entry] = static_cast<float>(sum_vs_random[HandRange::combo_index(hand[0], hand[1])] / 1225.0e0);
+        } else {
+            vs_random[entry] = static_cast<float>(sampled_equity(hand, nplayers, std::vector<HandRange>(),
+                                                                 multiway_trials, entry));
+        }
+    });
+
+    if(!PreflopTable::write(path, vs_random, heads_up, multiway_trials)) {
+        std::cout << "failed to write " << path << std::endl;
+        return 1;
+    }
+    auto tf = std::chrono::high_resolution_clock::now();
+    std::cout << "wrote " << path << " in " << std::chrono::duration<double>(tf - t0).count() << " seconds" << std::endl;
+    return 0;
+}
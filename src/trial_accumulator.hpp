@@ -0,0 +1,88 @@
+//
+//  trial_accumulator.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef trial_accumulator_hpp
+#define trial_accumulator_hpp
+
+#include "hand_evaluator.hpp"
+
+/* showdown results of one seat.  a split pot counts as a tie for every seat
+   in it, and each of them gets an equal share of the pot in tie_share.
+   tie_share_squares sums the squares of those shares, which together with
+   the wins gives the variance of the seat's pot share per trial, and
+   categories counts the seat's made hands by HandEvaluator::category(). */
+struct SeatTally {
+    long long wins;
+    long long ties;
+    double tie_share;
+    double tie_share_squares;
+    long long categories[HandEvaluator::NUM_CATEGORIES];
+    void clear();
+    void merge(const SeatTally& other);
+    double equity(long long ntrials) const;
+    double variance(long long ntrials) const;
+};
+
+/* everything one worker has tallied: how many trials it ran and every
+   seat's SeatTally, all 64 bit so a run can go far past 2^31 trials.  each
+   thread only ever adds to its own accumulator, with plain adds, and a run
+   merges them at its checkpoints, so no counter is shared between threads.
+   the padding keeps whatever sits after an accumulator (the next worker's,
+   say) off the cache line its last counters are on, whether or not the
+   allocator lines it up. */
+struct TrialAccumulator {
+    static const int MAX_SEATS = 10;
+    static const int CACHE_LINE = 64;
+    long long ntrials;
+    SeatTally seats[MAX_SEATS];
+    char padding[CACHE_LINE];
+    void clear();
+    void merge(const TrialAccumulator& other);
+};
+
+inline void SeatTally::clear() {
+    wins = 0;
+    ties = 0;
+    tie_share = 0.0e0;
+    tie_share_squares = 0.0e0;
+    for(int i = 0; i < HandEvaluator::NUM_CATEGORIES; ++i) categories[i] = 0;
+}
+
+inline void SeatTally::merge(const SeatTally& other) {
+    wins += other.wins;
+    ties += other.ties;
+    tie_share += other.tie_share;
+    tie_share_squares += other.tie_share_squares;
+    for(int i = 0; i < HandEvaluator::NUM_CATEGORIES; ++i) categories[i] += other.categories[i];
+}
+
+/* the seat's average share of the pot over ntrials trials */
+inline double SeatTally::equity(long long ntrials) const {
+    return ntrials > 0 ? (double(wins) + tie_share) / double(ntrials) : 0.0e0;
+}
+
+/* sample variance of the seat's share of the pot in one trial: 1 for a
+   win, 1 / n for an n way split, 0 for a loss */
+inline double SeatTally::variance(long long ntrials) const {
+    if(ntrials < 2) return 0.0e0;
+    double sum = double(wins) + tie_share;
+    double squares = double(wins) + tie_share_squares;
+    double variance = (squares - sum * sum / double(ntrials)) / double(ntrials - 1);
+    return variance > 0.0e0 ? variance : 0.0e0;
+}
+
+inline void TrialAccumulator::clear() {
+    ntrials = 0;
+    for(int i = 0; i < MAX_SEATS; ++i) seats[i].clear();
+}
+
+inline void TrialAccumulator::merge(const TrialAccumulator& other) {
+    ntrials += other.ntrials;
+    for(int i = 0; i < MAX_SEATS; ++i) seats[i].merge(other.seats[i]);
+}
+
+#endif /* trial_accumulator_hpp */
@@ -0,0 +1,249 @@
+//
+//  trial_engine.cpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#include "trial_engine.hpp"
+#include "hand_evaluator.hpp"
+#include "batch_evaluator.hpp"
+#include "alloc_counter.hpp"
+#include "card_set.hpp"
+
+TrialEngine::TrialEngine(const Deck& deck, const std::vector<Card>& hole_cards,
+                         const std::vector<Card>& community_cards, int nplayers, uint64_t seed, int stream,
+                         const std::vector<HandRange>& ranges) : deck_(deck) {
+    deck_.set_rng(Xoshiro256::stream(seed, stream));
+    // the evaluator builds its tables and picks its kernel on first use, which allocates; not in run()
+    BatchEvaluator::states_kernel();
+    nplayers_ = nplayers;
+    ncommunity_ = static_cast<int>(community_cards.size());
+    trial_allocations_ = 0;
+    clear_tallies();
+    // anything that is not left in the deck can't be in a ranged hand
+    CardSet dead_cards = CardSet::deck(deck.card_set().mask());
+    bool hero_known = hole_cards.size() == 2;
+    if(hero_known) {
+        for(int i = 0; i < 2; ++i) {
+            hole_cards_[0][i] = hole_cards[i];
+            deck_.remove(hole_cards[i]);
+            dead_cards.add(hole_cards[i]);
+        }
+    }
+    for(int i = 0; i < ncommunity_; ++i) {
+        board_[i] = community_cards[i];
+        deck_.remove(community_cards[i]);
+        dead_cards.add(community_cards[i]);
+    }
+    nranged_ = 0;
+    nrandom_ = 0;
+    dealable_ = true;
+    for(int seat = hero_known ? 1 : 0; seat < nplayers_; ++seat) {
+        if(seat < static_cast<int>(ranges.size()) && !ranges[seat].empty()) {
+            ranges_.push_back(ranges[seat]);
+            ranges_.back().remove_dead(dead_cards.mask());
+            if(ranges_.back().empty()) dealable_ = false;
+            ranged_seats_[nranged_++] = seat;
+        } else {
+            random_seats_[nrandom_++] = seat;
+        }
+    }
+    start_deck_ = deck_;
+}
+
+/* start over from another stream, e.g. the one assigned to the next chunk of
+   a run.  the sampler goes back to the order it had after construction too,
+   since the deals leave the undealt cards shuffled: a chunk then draws the
+   same cards whichever engine ran before it on that thread. */
+void TrialEngine::set_rng(const Xoshiro256& rng) {
+    deck_ = start_deck_;
+    deck_.set_rng(rng);
+}
+
+/* draws a combo for every ranged seat, all over again while two of them
+   collide, and takes their cards out of the deck */
+bool TrialEngine::deal_ranges() {
+    for(int draw = 0; draw < MAX_RANGE_DRAWS_; ++draw) {
+        uint64_t used = 0;
+        int i = 0;
+        for(; i < nranged_; ++i) {
+            int combo = ranges_[i].sample(deck_.rng());
+            uint64_t mask = ranges_[i].mask(combo);
+            if(used & mask) break;
+            used |= mask;
+            combos_[i] = combo;
+        }
+        if(i < nranged_) continue;
+        for(i = 0; i < nranged_; ++i) {
+            int seat = ranged_seats_[i];
+            hole_cards_[seat][0] = ranges_[i].first(combos_[i]);
+            hole_cards_[seat][1] = ranges_[i].second(combos_[i]);
+            deck_.deal_card(hole_cards_[seat][0]);
+            deck_.deal_card(hole_cards_[seat][1]);
+        }
+        return true;
+    }
+    dealable_ = false;
+    return false;
+}
+
+/* the missing hole cards, then the board */
+void TrialEngine::deal() {
+    for(int i = 0; i < nrandom_; ++i) {
+        for(int i_card = 0; i_card < 2; ++i_card) {
+            hole_cards_[random_seats_[i]][i_card] = deck_.deal();
+        }
+    }
+    for(int i_card = ncommunity_; i_card < 5; ++i_card) {
+        board_[i_card] = deck_.deal();
+    }
+}
+
+/* deals one board and the missing hole cards, and tallies the showdown for every seat */
+void TrialEngine::run_trial() {
+    if(nranged_ > 0 && !deal_ranges()) return;
+    deal();
+    // the board goes into the evaluator once, each player only adds two cards to it
+    HandEvaluator::State board = HandEvaluator::state(board_, 5);
+    int best = 0;
+    int nbest = 0;
+    for(int i_player = 0; i_player < nplayers_; ++i_player) {
+        int strength = HandEvaluator::evaluate(HandEvaluator::add(HandEvaluator::add(board, hole_cards_[i_player][0]),
+                                                                  hole_cards_[i_player][1]));
+        strengths_[i_player] = strength;
+        if(strength > best) {
+            best = strength;
+            nbest = 1;
+        } else if(strength == best) {
+            ++nbest;
+        }
+    }
+    ++accumulator_.ntrials;
+    for(int i_player = 0; i_player < nplayers_; ++i_player) {
+        ++accumulator_.seats[i_player].categories[HandEvaluator::category(strengths_[i_player])];
+    }
+    if(nbest == 1) {
+        for(int i_player = 0; i_player < nplayers_; ++i_player) {
+            if(strengths_[i_player] == best) ++accumulator_.seats[i_player].wins;
+        }
+    } else {
+        double share = 1.0e0 / nbest;
+        for(int i_player = 0; i_player < nplayers_; ++i_player) {
+            if(strengths_[i_player] == best) {
+                ++accumulator_.seats[i_player].ties;
+                accumulator_.seats[i_player].tie_share += share;
+                accumulator_.seats[i_player].tie_share_squares += share * share;
+            }
+        }
+    }
+    deck_.undo_all();
+}
+
+/* makes up to ntrials deals, in the same order run_trial() would, and keeps
+   every seat's 7 card state; returns how many were made, fewer only if the
+   ranges ran dry.  the rank table entries are prefetched as the states come */
+int TrialEngine::deal_batch(int ntrials) {
+    int n = 0;
+    for(; n < ntrials; ++n) {
+        if(nranged_ > 0 && !deal_ranges()) break;
+        deal();
+        HandEvaluator::State board = HandEvaluator::state(board_, 5);
+        for(int i_player = 0; i_player < nplayers_; ++i_player) {
+            HandEvaluator::State hand = HandEvaluator::add(HandEvaluator::add(board, hole_cards_[i_player][0]),
+                                                           hole_cards_[i_player][1]);
+            HandEvaluator::prefetch(hand);
+            keys_[i_player][n] = hand.key;
+            masks_[i_player][n] = hand.mask;
+        }
+        deck_.undo_all();
+    }
+    return n;
+}
+
+void TrialEngine::evaluate_batch(int ntrials) {
+    for(int i_player = 0; i_player < nplayers_; ++i_player) {
+        BatchEvaluator::evaluate_states(keys_[i_player], masks_[i_player], 7, ntrials, batch_strengths_[i_player]);
+    }
+}
+
+/* the best strength of each trial and how many seats have it, then one pass
+   per seat over the trials.  every seat's tie_share is still summed in trial
+   order, so the totals match run_trial()'s to the last bit */
+void TrialEngine::tally_batch(int ntrials) {
+    for(int t = 0; t < ntrials; ++t) {
+        best_[t] = 0;
+        nbest_[t] = 0;
+    }
+    for(int i_player = 0; i_player < nplayers_; ++i_player) {
+        const int* strengths = batch_strengths_[i_player];
+        for(int t = 0; t < ntrials; ++t) {
+            best_[t] = strengths[t] > best_[t] ? strengths[t] : best_[t];
+        }
+    }
+    for(int i_player = 0; i_player < nplayers_; ++i_player) {
+        const int* strengths = batch_strengths_[i_player];
+        for(int t = 0; t < ntrials; ++t) nbest_[t] += strengths[t] == best_[t];
+    }
+    for(int i_player = 0; i_player < nplayers_; ++i_player) {
+        const int* strengths = batch_strengths_[i_player];
+        SeatTally& tally = accumulator_.seats[i_player];
+        long long wins = 0;
+        long long ties = 0;
+        for(int t = 0; t < ntrials; ++t) {
+            bool top = strengths[t] == best_[t];
+            wins += top && nbest_[t] == 1;
+            ties += top && nbest_[t] > 1;
+        }
+        for(int t = 0; t < ntrials; ++t) {
+            if(strengths[t] == best_[t] && nbest_[t] > 1) {
+                double share = 1.0e0 / nbest_[t];
+                tally.tie_share += share;
+                tally.tie_share_squares += share * share;
+            }
+        }
+        for(int t = 0; t < ntrials; ++t) ++tally.categories[HandEvaluator::category(strengths[t])];
+        tally.wins += wins;
+        tally.ties += ties;
+    }
+    accumulator_.ntrials += ntrials;
+}
+
+void TrialEngine::run(long long ntrials) {
+    long long allocations = AllocationCounter::count();
+    while(ntrials > 0 && dealable_) {
+        int n = deal_batch(ntrials < BATCH_SIZE_ ? static_cast<int>(ntrials) : BATCH_SIZE_);
+        evaluate_batch(n);
+        tally_batch(n);
+        ntrials -= n;
+    }
+    trial_allocations_ += AllocationCounter::count() - allocations;
+}
+
+/* false once the ranges turned out not to fit together (or around the known cards) */
+bool TrialEngine::dealable() const {
+    return dealable_;
+}
+
+int TrialEngine::nplayers() const {
+    return nplayers_;
+}
+
+/* everything seat has won since the last clear_tallies() */
+const SeatTally& TrialEngine::tally(int seat) const {
+    return accumulator_.seats[seat];
+}
+
+/* every seat's tally and the number of trials they cover */
+const TrialAccumulator& TrialEngine::accumulator() const {
+    return accumulator_;
+}
+
+void TrialEngine::clear_tallies() {
+    accumulator_.clear();
+}
+
+/* heap allocations made by this thread inside run(), 0 unless built with -DPOKER_COUNT_ALLOCATIONS */
+long long TrialEngine::trial_allocations() const {
+    return trial_allocations_;
+}
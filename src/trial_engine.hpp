@@ -0,0 +1,87 @@
+//
+//  trial_engine.hpp
+//  poker_calculator
+//
+//  Copyright © 2016 Ben Ellis. All rights reserved.
+//
+
+#ifndef trial_engine_hpp
+#define trial_engine_hpp
+
+#include <vector>
+
+#include "card.hpp"
+#include "deck.hpp"
+#include "deck_sampler.hpp"
+#include "hand_range.hpp"
+#include "trial_accumulator.hpp"
+
+/* one Monte Carlo worker.  all scratch state (its own deck sampler, the hole
+   cards, the 7 card buffer and the strengths) is set up once in the
+   constructor, so a trial deals, scores and undoes the deal without touching
+   the heap.  each engine draws from its own jump-ahead stream of the run's
+   seed, so a run is reproducible for a given seed and number of engines.
+
+   a seat with a non-empty entry in ranges is dealt a combo from its range
+   instead of two random cards.  the ranged seats are drawn together and
+   redrawn together whenever two of them share a card, which keeps the joint
+   draw proportional to the product of the weights; the random seats and the
+   board then come from what is left.  seat 0 uses hole_cards when it has
+   two of them.
+
+   run() works through the trials in batches of BATCH_SIZE_: every deal of a
+   batch is made first and each seat's 7 cards kept as an evaluator state, in
+   one array per seat, then the whole batch is scored a seat at a time by
+   BatchEvaluator and the showdowns tallied in a last pass.  run_trial()
+   does one trial start to finish, which gives the same tallies.
+
+   the tallies are the engine's own TrialAccumulator; a run with several
+   engines merges theirs through accumulator() whenever it wants totals. */
+class TrialEngine
+{
+public:
+    static const int MAX_PLAYERS = TrialAccumulator::MAX_SEATS;
+    TrialEngine(const Deck& deck, const std::vector<Card>& hole_cards, const std::vector<Card>& community_cards,
+                int nplayers, uint64_t seed, int stream,
+                const std::vector<HandRange>& ranges = std::vector<HandRange>());
+    void set_rng(const Xoshiro256& rng);
+    void run_trial();
+    bool dealable() const;
+    void run(long long ntrials);
+    int nplayers() const;
+    const SeatTally& tally(int seat) const;
+    const TrialAccumulator& accumulator() const;
+    void clear_tallies();
+    long long trial_allocations() const;
+private:
+    static const int MAX_RANGE_DRAWS_ = 100000;
+    static const int BATCH_SIZE_ = 256;
+    DeckSampler deck_;
+    DeckSampler start_deck_;
+    int nplayers_;
+    int ncommunity_;
+    long long trial_allocations_;
+    std::vector<HandRange> ranges_;
+    int ranged_seats_[MAX_PLAYERS];
+    int nranged_;
+    int random_seats_[MAX_PLAYERS];
+    int nrandom_;
+    int combos_[MAX_PLAYERS];
+    bool dealable_;
+    Card hole_cards_[MAX_PLAYERS][2];
+    Card board_[5];
+    int strengths_[MAX_PLAYERS];
+    TrialAccumulator accumulator_;
+    uint64_t keys_[MAX_PLAYERS][BATCH_SIZE_];
+    uint64_t masks_[MAX_PLAYERS][BATCH_SIZE_];
+    int batch_strengths_[MAX_PLAYERS][BATCH_SIZE_];
+    int best_[BATCH_SIZE_];
+    int nbest_[BATCH_SIZE_];
+    bool deal_ranges();
+    void deal();
+    int deal_batch(int ntrials);
+    void evaluate_batch(int ntrials);
+    void tally_batch(int ntrials);
+};
+
+#endif /* trial_engine_hpp */